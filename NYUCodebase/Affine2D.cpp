@@ -0,0 +1,88 @@
+#include "Affine2D.h"
+#include <math.h>
+
+Affine2D::Affine2D() {
+    Identity();
+}
+
+Affine2D::Affine2D(float a_, float b_, float c_, float d_, float tx_, float ty_) {
+    a = a_;
+    b = b_;
+    c = c_;
+    d = d_;
+    tx = tx_;
+    ty = ty_;
+}
+
+void Affine2D::Identity() {
+    a = 1.0f;
+    b = 0.0f;
+    c = 0.0f;
+    d = 1.0f;
+    tx = 0.0f;
+    ty = 0.0f;
+}
+
+Affine2D Affine2D::operator * (const Affine2D &o) const {
+    return Affine2D(a * o.a + c * o.b,
+                    b * o.a + d * o.b,
+                    a * o.c + c * o.d,
+                    b * o.c + d * o.d,
+                    a * o.tx + c * o.ty + tx,
+                    b * o.tx + d * o.ty + ty);
+}
+
+Affine2D Affine2D::Inverse() const {
+    float invDet = 1.0f / (a * d - b * c);
+    float ia = d * invDet;
+    float ib = -b * invDet;
+    float ic = -c * invDet;
+    float id = a * invDet;
+    return Affine2D(ia, ib, ic, id, -(ia * tx + ic * ty), -(ib * tx + id * ty));
+}
+
+void Affine2D::Translate(float x, float y) {
+    tx += a * x + c * y;
+    ty += b * x + d * y;
+}
+
+void Affine2D::Scale(float x, float y) {
+    a *= x;
+    b *= x;
+    c *= y;
+    d *= y;
+}
+
+void Affine2D::Rotate(float rotation) {
+    (*this) = (*this) * Rotation(rotation);
+}
+
+void Affine2D::TransformPoint(float x, float y, float *outX, float *outY) const {
+    *outX = a * x + c * y + tx;
+    *outY = b * x + d * y + ty;
+}
+
+Matrix Affine2D::ToMatrix() const {
+    Matrix m;
+    m.m[0][0] = a;
+    m.m[0][1] = b;
+    m.m[1][0] = c;
+    m.m[1][1] = d;
+    m.m[3][0] = tx;
+    m.m[3][1] = ty;
+    return m;
+}
+
+Affine2D Affine2D::Translation(float x, float y) {
+    return Affine2D(1.0f, 0.0f, 0.0f, 1.0f, x, y);
+}
+
+Affine2D Affine2D::Scaling(float x, float y) {
+    return Affine2D(x, 0.0f, 0.0f, y, 0.0f, 0.0f);
+}
+
+Affine2D Affine2D::Rotation(float rotation) {
+    float cr = cos(rotation);
+    float sr = sin(rotation);
+    return Affine2D(cr, sr, -sr, cr, 0.0f, 0.0f);
+}
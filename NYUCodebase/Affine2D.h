@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Matrix.h"
+
+//2D affine transform in 6 floats
+//    | a c tx |
+//    | b d ty |
+//Points map as x' = a*x + c*y + tx, y' = b*x + d*y + ty.
+class Affine2D {
+    public:
+    
+        Affine2D();
+        Affine2D(float a, float b, float c, float d, float tx, float ty);
+    
+        float a, b, c, d;
+        float tx, ty;
+    
+        void Identity();
+        //(this * other) maps a point through other first, then this
+        Affine2D operator * (const Affine2D &other) const;
+        Affine2D Inverse() const;
+    
+        //Like Matrix::Translate etc, the new step applies to points before the existing ones
+        void Translate(float x, float y);
+        void Scale(float x, float y);
+        void Rotate(float rotation);
+    
+        void TransformPoint(float x, float y, float *outX, float *outY) const;
+    
+        //Expands to the 4x4 layout the shaders expect
+        Matrix ToMatrix() const;
+    
+        static Affine2D Translation(float x, float y);
+        static Affine2D Scaling(float x, float y);
+        static Affine2D Rotation(float rotation);
+};
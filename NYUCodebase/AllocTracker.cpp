@@ -0,0 +1,208 @@
+#include "AllocTracker.h"
+
+#ifdef ALLOC_TRACKING
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <new>
+
+//The game allocates from the main thread only, so plain counters are enough.
+//Nothing in here may call operator new itself.
+
+#define MAX_ALLOC_TAGS 32
+#define UNTAGGED "untagged"
+
+struct FrameAllocs {
+	AllocStats total;
+	AllocTagStats tags[MAX_ALLOC_TAGS];
+	int tag_count = 0;
+};
+
+static FrameAllocs current_frame;
+static FrameAllocs last_frame;
+static const char* current_tag = UNTAGGED;
+static size_t live_bytes = 0;
+static unsigned int frame_number = 0;
+static FILE* csv_file = NULL;
+
+
+static AllocStats& tag_stats(const char* tag) {
+	for (int i = 0; i < current_frame.tag_count; i++) {
+		if (current_frame.tags[i].tag == tag) {
+			return current_frame.tags[i].stats;
+		}
+	}
+
+	if (current_frame.tag_count == MAX_ALLOC_TAGS) {
+		//Out of slots, lump the rest into the last one
+		return current_frame.tags[MAX_ALLOC_TAGS - 1].stats;
+	}
+
+	AllocTagStats& entry = current_frame.tags[current_frame.tag_count++];
+	entry.tag = tag;
+	entry.stats = AllocStats();
+	return entry.stats;
+}
+
+static void record_alloc(size_t size, const char* tag) {
+	current_frame.total.allocs++;
+	current_frame.total.bytes_allocated += size;
+	AllocStats& stats = tag_stats(tag);
+	stats.allocs++;
+	stats.bytes_allocated += size;
+	live_bytes += size;
+}
+
+//Frees are charged to the tag that made the block, not whichever scope is open now
+static void record_free(size_t size, const char* tag) {
+	current_frame.total.frees++;
+	current_frame.total.bytes_freed += size;
+	AllocStats& stats = tag_stats(tag);
+	stats.frees++;
+	stats.bytes_freed += size;
+	live_bytes -= size;
+}
+
+
+static void write_csv_row(const char* tag, const AllocStats& stats) {
+	fprintf(csv_file, "%u,%s,%u,%u,%u,%u,%u\n", frame_number, tag, stats.allocs, stats.frees,
+		(unsigned int)stats.bytes_allocated, (unsigned int)stats.bytes_freed, (unsigned int)live_bytes);
+}
+
+void alloc_tracker_begin_frame() {
+	if (csv_file != NULL) {
+		write_csv_row("total", current_frame.total);
+		for (int i = 0; i < current_frame.tag_count; i++) {
+			write_csv_row(current_frame.tags[i].tag, current_frame.tags[i].stats);
+		}
+	}
+
+	last_frame = current_frame;
+	current_frame = FrameAllocs();
+	frame_number++;
+}
+
+const AllocStats& alloc_frame_stats() {
+	return current_frame.total;
+}
+
+const AllocStats& alloc_last_frame_stats() {
+	return last_frame.total;
+}
+
+int alloc_last_frame_tags(const AllocTagStats** tags) {
+	*tags = last_frame.tags;
+	return last_frame.tag_count;
+}
+
+size_t alloc_live_bytes() {
+	return live_bytes;
+}
+
+bool alloc_csv_open(const char* path) {
+	alloc_csv_close();
+	csv_file = fopen(path, "w");
+	if (csv_file == NULL) {
+		return false;
+	}
+	fprintf(csv_file, "frame,tag,allocs,frees,bytes_allocated,bytes_freed,live_bytes\n");
+	return true;
+}
+
+void alloc_csv_close() {
+	if (csv_file != NULL) {
+		fclose(csv_file);
+		csv_file = NULL;
+	}
+}
+
+
+AllocScope::AllocScope(const char* tag) {
+	previous_tag = current_tag;
+	current_tag = tag;
+}
+
+AllocScope::~AllocScope() {
+	current_tag = previous_tag;
+}
+
+
+//Every block carries its size and tag in a header right in front of the pointer
+//handed out, so delete can account for the bytes it frees against their owner
+#define ALLOC_HEADER_SIZE 16
+
+struct AllocHeader {
+	size_t size;
+	const char* tag;
+};
+static_assert(sizeof(AllocHeader) <= ALLOC_HEADER_SIZE, "alloc header must fit its slot");
+
+static void* write_header(char* block, size_t offset, size_t size) {
+	AllocHeader* header = (AllocHeader*)(block + offset) - 1;
+	header->size = size;
+	header->tag = current_tag;
+	record_alloc(size, current_tag);
+	return block + offset;
+}
+
+static void read_header(void* ptr) {
+	AllocHeader* header = (AllocHeader*)ptr - 1;
+	record_free(header->size, header->tag);
+}
+
+void* operator new(size_t size) {
+	char* block = (char*)malloc(size + ALLOC_HEADER_SIZE);
+	if (block == NULL) {
+		throw std::bad_alloc();
+	}
+	return write_header(block, ALLOC_HEADER_SIZE, size);
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr == NULL) {
+		return;
+	}
+	read_header(ptr);
+	free((char*)ptr - ALLOC_HEADER_SIZE);
+}
+
+//C++14 compilers call the sized forms when the size is known, the header already has it
+void operator delete(void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+
+//Over-aligned types (GameObject) go through these, the header takes a whole alignment step
+void* operator new(size_t size, std::align_val_t align) {
+	size_t alignment = (size_t)align < ALLOC_HEADER_SIZE ? ALLOC_HEADER_SIZE : (size_t)align;
+	size_t bytes = size + alignment;
+#ifdef _WIN32
+	char* block = (char*)_aligned_malloc(bytes, alignment);
+#else
+	char* block = (char*)aligned_alloc(alignment, (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+	if (block == NULL) {
+		throw std::bad_alloc();
+	}
+	return write_header(block, alignment, size);
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept {
+	if (ptr == NULL) {
+		return;
+	}
+	size_t alignment = (size_t)align < ALLOC_HEADER_SIZE ? ALLOC_HEADER_SIZE : (size_t)align;
+	char* block = (char*)ptr - alignment;
+	read_header(ptr);
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+void operator delete(void* ptr, size_t, std::align_val_t align) noexcept {
+	operator delete(ptr, align);
+}
+
+#endif
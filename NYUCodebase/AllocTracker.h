@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stddef.h>
+
+//Global allocation instrumentation. When ALLOC_TRACKING is defined, the global
+//operator new/delete are replaced and every allocation is counted against the
+//current frame and the innermost ALLOC_TAG scope.
+//Debug builds always track (the main loop uses it to police steady-state frames),
+//define ALLOC_TRACKING in the project to get it in release builds too.
+#if defined(_DEBUG) && !defined(ALLOC_TRACKING)
+	#define ALLOC_TRACKING
+#endif
+
+struct AllocStats {
+	unsigned int allocs = 0;
+	unsigned int frees = 0;
+	size_t bytes_allocated = 0;
+	size_t bytes_freed = 0;
+};
+
+struct AllocTagStats {
+	const char* tag;
+	AllocStats stats;
+};
+
+#ifdef ALLOC_TRACKING
+
+//Call once at the top of every frame, closes out the previous frame's numbers
+void alloc_tracker_begin_frame();
+
+//Numbers for the frame in progress and for the last completed frame
+const AllocStats& alloc_frame_stats();
+const AllocStats& alloc_last_frame_stats();
+
+//Per-tag breakdown of the last completed frame, returns the number of tags
+int alloc_last_frame_tags(const AllocTagStats** tags);
+
+//Bytes currently allocated through operator new
+size_t alloc_live_bytes();
+
+//Append one row per tag per frame to a CSV file until closed
+bool alloc_csv_open(const char* path);
+void alloc_csv_close();
+
+//Attributes allocations made while alive to `tag` (a string literal)
+class AllocScope {
+public:
+	AllocScope(const char* tag);
+	~AllocScope();
+private:
+	const char* previous_tag;
+};
+
+#define ALLOC_TAG(tag) AllocScope alloc_scope(tag)
+
+#else
+
+inline void alloc_tracker_begin_frame() {}
+inline const AllocStats& alloc_frame_stats() { static AllocStats empty; return empty; }
+inline const AllocStats& alloc_last_frame_stats() { return alloc_frame_stats(); }
+inline int alloc_last_frame_tags(const AllocTagStats** tags) { *tags = NULL; return 0; }
+inline size_t alloc_live_bytes() { return 0; }
+inline bool alloc_csv_open(const char*) { return false; }
+inline void alloc_csv_close() {}
+
+#define ALLOC_TAG(tag)
+
+#endif
@@ -0,0 +1,168 @@
+#include "BarrierMask.h"
+#include "PerfStats.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+//Bits x0..x1 of a row, x0 <= x1 inside 0..31
+static inline uint32_t column_bits(int x0, int x1) {
+	uint32_t high = x1 >= 31 ? 0xFFFFFFFFu : (2u << x1) - 1u;
+	uint32_t low = (1u << x0) - 1u;
+	return high & ~low;
+}
+
+bool BarrierMask::test(int x0, int y0, int x1, int y1) const {
+	x0 = std::max(x0, 0);
+	y0 = std::max(y0, 0);
+	x1 = std::min(x1, BARRIER_MASK_WIDTH - 1);
+	y1 = std::min(y1, BARRIER_MASK_HEIGHT - 1);
+	if (x0 > x1 || y0 > y1) {
+		return false;
+	}
+
+	uint32_t columns = column_bits(x0, x1);
+	for (int y = y0; y <= y1; y++) {
+		if (rows[y] & columns) {
+			return true;
+		}
+	}
+	return false;
+}
+
+float BarrierMask::sweep(float x0, float y0, float x1, float y1, float dx, float dy) const {
+	int steps = (int)ceilf(std::max(fabsf(dx), fabsf(dy)));
+	for (int step = 0; step <= steps; step++) {
+		float t = steps == 0 ? 0.0f : (float)step / steps;
+		float offset_x = dx * t;
+		float offset_y = dy * t;
+		if (test((int)floorf(x0 + offset_x), (int)floorf(y0 + offset_y), (int)floorf(x1 + offset_x), (int)floorf(y1 + offset_y))) {
+			return t;
+		}
+	}
+	return -1.0f;
+}
+
+bool BarrierMask::empty() const {
+	for (int y = 0; y < BARRIER_MASK_HEIGHT; y++) {
+		if (rows[y]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+BarrierAtlas::BarrierAtlas() {
+}
+
+BarrierAtlas::~BarrierAtlas() {
+	if (texture) {
+		glDeleteTextures(1, &texture);
+	}
+}
+
+int BarrierAtlas::atlas_x(int index) const {
+	return (index % BARRIER_ATLAS_COLUMNS) * BARRIER_MASK_WIDTH;
+}
+
+int BarrierAtlas::atlas_y(int index) const {
+	return (index / BARRIER_ATLAS_COLUMNS) * BARRIER_MASK_HEIGHT;
+}
+
+SheetRect BarrierAtlas::rect(int index) const {
+	return sheet_rect(BARRIER_ATLAS_SIZE, BARRIER_ATLAS_SIZE, (float)atlas_x(index), (float)atlas_y(index), BARRIER_MASK_WIDTH, BARRIER_MASK_HEIGHT);
+}
+
+void BarrierAtlas::init(const unsigned char* sprite, int count) {
+	count = std::min(count, BARRIER_ATLAS_CAPACITY);
+
+	BarrierMask undamaged;
+	for (int y = 0; y < BARRIER_MASK_HEIGHT; y++) {
+		undamaged.rows[y] = 0;
+		for (int x = 0; x < BARRIER_MASK_WIDTH; x++) {
+			if (sprite[(y * BARRIER_MASK_WIDTH + x) * 4 + 3] >= 128) {
+				undamaged.rows[y] |= 1u << x;
+			}
+		}
+	}
+	//Sized for a full atlas up front, so later waves re-init without allocating
+	masks.reserve(BARRIER_ATLAS_CAPACITY);
+	dirty_first.reserve(BARRIER_ATLAS_CAPACITY);
+	dirty_last.reserve(BARRIER_ATLAS_CAPACITY);
+	masks.assign(count, undamaged);
+	dirty_first.assign(count, BARRIER_MASK_HEIGHT);
+	dirty_last.assign(count, -1);
+
+	pixels.assign(BARRIER_ATLAS_SIZE * BARRIER_ATLAS_SIZE * 4, 0);
+	for (int i = 0; i < count; i++) {
+		for (int y = 0; y < BARRIER_MASK_HEIGHT; y++) {
+			memcpy(&pixels[((atlas_y(i) + y) * BARRIER_ATLAS_SIZE + atlas_x(i)) * 4], sprite + y * BARRIER_MASK_WIDTH * 4, BARRIER_MASK_WIDTH * 4);
+		}
+	}
+
+	if (texture == 0) {
+		glGenTextures(1, &texture);
+	}
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BARRIER_ATLAS_SIZE, BARRIER_ATLAS_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+	//Nearest keeps carved edges crisp and stops neighbours in the atlas bleeding in
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+bool BarrierAtlas::carve(int index, int x, int y, int radius) {
+	BarrierMask& mask = masks[index];
+	int y0 = std::max(y - radius, 0);
+	int y1 = std::min(y + radius, BARRIER_MASK_HEIGHT - 1);
+	for (int row = y0; row <= y1; row++) {
+		//Half width of the disc on this row
+		int dy = row - y;
+		int half = (int)sqrtf((float)(radius * radius - dy * dy));
+		int x0 = std::max(x - half, 0);
+		int x1 = std::min(x + half, BARRIER_MASK_WIDTH - 1);
+		if (x0 > x1) {
+			continue;
+		}
+
+		uint32_t cleared = mask.rows[row] & column_bits(x0, x1);
+		if (cleared == 0) {
+			continue;
+		}
+		mask.rows[row] &= ~cleared;
+
+		unsigned char* texel = &pixels[((atlas_y(index) + row) * BARRIER_ATLAS_SIZE + atlas_x(index)) * 4];
+		for (int column = x0; column <= x1; column++) {
+			texel[column * 4 + 3] = 0;
+		}
+		dirty_first[index] = std::min(dirty_first[index], row);
+		dirty_last[index] = std::max(dirty_last[index], row);
+	}
+	return mask.empty();
+}
+
+void BarrierAtlas::upload() {
+	bool bound = false;
+	for (int i = 0; i < (int)masks.size(); i++) {
+		if (dirty_first[i] > dirty_last[i]) {
+			continue;
+		}
+
+		if (!bound) {
+			GL_STATE(glBindTexture(GL_TEXTURE_2D, texture));
+			//Rows are read straight out of the atlas copy
+			GL_STATE(glPixelStorei(GL_UNPACK_ROW_LENGTH, BARRIER_ATLAS_SIZE));
+			bound = true;
+		}
+
+		int y = atlas_y(i) + dirty_first[i];
+		GL_UPLOAD(glTexSubImage2D(GL_TEXTURE_2D, 0, atlas_x(i), y, BARRIER_MASK_WIDTH, dirty_last[i] - dirty_first[i] + 1,
+			GL_RGBA, GL_UNSIGNED_BYTE, &pixels[(y * BARRIER_ATLAS_SIZE + atlas_x(i)) * 4]));
+
+		dirty_first[i] = BARRIER_MASK_HEIGHT;
+		dirty_last[i] = -1;
+	}
+
+	if (bound) {
+		GL_STATE(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	}
+}
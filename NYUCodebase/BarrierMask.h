@@ -0,0 +1,74 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <stdint.h>
+#include <vector>
+#include "ConstMath.h"
+
+//One bit per texel, a row of the barrier fits one uint32
+#define BARRIER_MASK_WIDTH 32
+#define BARRIER_MASK_HEIGHT 16
+
+//Solid texels of one barrier, row 0 is the top of the sprite
+struct BarrierMask {
+	uint32_t rows[BARRIER_MASK_HEIGHT];
+
+	//Any solid texel in the inclusive texel rect, clipped to the mask
+	bool test(int x0, int y0, int x1, int y1) const;
+
+	//Moves the texel rect [x0, x1] x [y0, y1] by (dx, dy) texels one texel at a time and
+	//returns the first fraction 0..1 of the move at which it covers a solid texel, or -1
+	float sweep(float x0, float y0, float x1, float y1, float dx, float dy) const;
+
+	bool empty() const;
+};
+
+
+//Destructible barriers. Every barrier gets its own copy of the undamaged sprite in a
+//shared atlas texture, so all of them still draw in one batch run. Hits clear mask
+//bits and the matching texels, and upload() sends only the rows that changed.
+//
+//	atlas.init(sprite_rgba, 3);
+//	Sprite sprite(atlas.texture, atlas.rect(i), size);
+//	...on a hit: atlas.carve(i, x, y, radius); ... before drawing: atlas.upload();
+class BarrierAtlas {
+public:
+	BarrierAtlas();
+	~BarrierAtlas();
+
+	//pixels is the RGBA8 undamaged sprite, BARRIER_MASK_WIDTH x BARRIER_MASK_HEIGHT, top row first.
+	//Texels with alpha at or above half are solid.
+	void init(const unsigned char* pixels, int count);
+
+	int size() const { return (int)masks.size(); }
+	const BarrierMask& mask(int index) const { return masks[index]; }
+	//Where barrier index sits in the atlas, for its Sprite
+	SheetRect rect(int index) const;
+
+	//Clears a disc of texels around (x, y), returns true if the barrier has nothing left
+	bool carve(int index, int x, int y, int radius);
+	//glTexSubImage2D of the dirty rows of each barrier
+	void upload();
+
+	GLuint texture = 0;
+
+private:
+	BarrierAtlas(const BarrierAtlas&);
+	BarrierAtlas& operator=(const BarrierAtlas&);
+
+	int atlas_x(int index) const;
+	int atlas_y(int index) const;
+
+	std::vector<BarrierMask> masks;
+	std::vector<int> dirty_first; //first and last dirty row per barrier, first > last when clean
+	std::vector<int> dirty_last;
+	std::vector<unsigned char> pixels; //CPU copy of the atlas, RGBA8
+};
+
+//2 columns by 4 rows of barriers, square so uv aspect matches texel aspect
+#define BARRIER_ATLAS_SIZE 64
+#define BARRIER_ATLAS_COLUMNS (BARRIER_ATLAS_SIZE / BARRIER_MASK_WIDTH)
+#define BARRIER_ATLAS_CAPACITY (BARRIER_ATLAS_COLUMNS * (BARRIER_ATLAS_SIZE / BARRIER_MASK_HEIGHT))
@@ -0,0 +1,62 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+volatile const void* benchmark_sink;
+
+void benchmark_do_not_optimize(const void* ptr) {
+	benchmark_sink = ptr;
+}
+
+void BenchmarkSuite::add_result(const char* name, int iterations, std::vector<double>& samples) {
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		sum += samples[i];
+	}
+	double mean = sum / samples.size();
+
+	double variance = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		variance += (samples[i] - mean) * (samples[i] - mean);
+	}
+
+	BenchmarkResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.repetitions = (int)samples.size();
+	result.mean_ns = mean;
+	result.median_ns = samples[samples.size() / 2];
+	result.stddev_ns = sqrt(variance / samples.size());
+	result.min_ns = samples.front();
+	result.max_ns = samples.back();
+	results.push_back(result);
+}
+
+void BenchmarkSuite::print() const {
+	printf("%-32s %12s %12s %10s\n", "benchmark", "median ns/op", "mean ns/op", "stddev");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& r = results[i];
+		printf("%-32s %12.2f %12.2f %10.2f\n", r.name.c_str(), r.median_ns, r.mean_ns, r.stddev_ns);
+	}
+}
+
+bool BenchmarkSuite::write_json(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "{\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& r = results[i];
+		fprintf(file, "    {\"name\": \"%s\", \"iterations\": %d, \"repetitions\": %d, \"median_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f}%s\n",
+			r.name.c_str(), r.iterations, r.repetitions, r.median_ns, r.mean_ns, r.stddev_ns, r.min_ns, r.max_ns,
+			i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+//Minimal microbenchmark harness. Each case runs `iterations` calls of its body,
+//repeated `repetitions` times after one warm-up pass; stats are over the
+//per-repetition ns/op.
+
+struct BenchmarkResult {
+	std::string name;
+	int iterations;
+	int repetitions;
+	double mean_ns;
+	double median_ns;
+	double stddev_ns;
+	double min_ns;
+	double max_ns;
+};
+
+//Keeps the optimizer from dropping work whose result is otherwise unused
+void benchmark_do_not_optimize(const void* ptr);
+
+class BenchmarkSuite {
+public:
+	int repetitions = 15;
+	std::vector<BenchmarkResult> results;
+
+	template <class Body>
+	void run(const char* name, int iterations, Body body){
+		std::vector<double> samples;
+		for (int rep = -1; rep < repetitions; rep++){
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int i = 0; i < iterations; i++){
+				body(i);
+			}
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+			//rep -1 is the warm-up pass
+			if (rep >= 0){
+				double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+				samples.push_back(ns / iterations);
+			}
+		}
+		add_result(name, iterations, samples);
+	}
+
+	void print() const;
+	bool write_json(const char* path) const;
+
+private:
+	void add_result(const char* name, int iterations, std::vector<double>& samples);
+};
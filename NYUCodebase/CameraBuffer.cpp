@@ -0,0 +1,28 @@
+#include "CameraBuffer.h"
+#include "PerfStats.h"
+#include <string.h>
+
+CameraBuffer::CameraBuffer() {
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(matrices), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, buffer);
+}
+
+CameraBuffer::~CameraBuffer() {
+	glDeleteBuffers(1, &buffer);
+}
+
+void CameraBuffer::update(const Matrix& projection, const Matrix& view) {
+	if (uploaded && memcmp(matrices, projection.ml, sizeof(projection.ml)) == 0 && memcmp(matrices + 16, view.ml, sizeof(view.ml)) == 0) {
+		return;
+	}
+
+	memcpy(matrices, projection.ml, sizeof(projection.ml));
+	memcpy(matrices + 16, view.ml, sizeof(view.ml));
+	GL_STATE(glBindBuffer(GL_UNIFORM_BUFFER, buffer));
+	GL_UPLOAD(glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), matrices));
+	GL_STATE(glBindBuffer(GL_UNIFORM_BUFFER, 0));
+	uploaded = true;
+}
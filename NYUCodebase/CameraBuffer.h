@@ -0,0 +1,33 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include "Matrix.h"
+
+//Uniform buffer binding point shared by every program's Camera block
+#define CAMERA_BLOCK_BINDING 0
+
+//Projection and view matrices for all programs in one uniform buffer, matching
+//
+//	uniform Camera { mat4 projectionMatrix; mat4 viewMatrix; };
+//
+//in the vertex shaders. Programs attach to it with
+//ShaderProgram::BindUniformBlock("Camera", CAMERA_BLOCK_BINDING). update() is
+//called once per frame and only uploads when a matrix actually changed.
+class CameraBuffer {
+public:
+	CameraBuffer();
+	~CameraBuffer();
+
+	void update(const Matrix& projection, const Matrix& view);
+
+private:
+	CameraBuffer(const CameraBuffer&);
+	CameraBuffer& operator=(const CameraBuffer&);
+
+	GLuint buffer = 0;
+	bool uploaded = false;
+	float matrices[32]; //projection then view, std140 lays mat4 out as 16 packed floats
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+//Math helpers that can run at compile time, so constant transforms and
+//texture layouts are baked into the binary instead of computed at startup
+
+constexpr float PI = 3.14159265358979323846f;
+
+constexpr float degrees_to_radians(float degrees) {
+	return degrees * PI / 180.0f;
+}
+
+constexpr float radians_to_degrees(float radians) {
+	return radians * 180.0f / PI;
+}
+
+
+//A region of a sprite sheet in texture coordinates
+struct SheetRect {
+	float u;
+	float v;
+	float width;
+	float height;
+};
+
+//Converts a pixel rectangle of a sheet_width x sheet_height texture
+constexpr SheetRect sheet_rect(float sheet_width, float sheet_height, float x, float y, float w, float h) {
+	return SheetRect{ x / sheet_width, y / sheet_height, w / sheet_width, h / sheet_height };
+}
+
+
+static_assert(degrees_to_radians(180.0f) == PI, "degrees_to_radians");
+static_assert(degrees_to_radians(0.0f) == 0.0f, "degrees_to_radians");
+static_assert(radians_to_degrees(PI) == 180.0f, "radians_to_degrees");
+static_assert(sheet_rect(480.0f, 480.0f, 48.0f, 0.0f, 16.0f, 16.0f).u == 0.1f, "sheet_rect");
+static_assert(sheet_rect(512.0f, 256.0f, 0.0f, 64.0f, 32.0f, 32.0f).v == 0.25f, "sheet_rect");
@@ -0,0 +1,123 @@
+#include "FileWatcher.h"
+#include <chrono>
+#include <sys/stat.h>
+
+#ifdef __linux__
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+
+FileWatcher file_watcher;
+
+//Seconds between modification time scans when inotify isn't available
+static const double scan_interval = 0.5;
+
+static long long modified_time(const std::string& path) {
+#ifdef _WIN32
+	struct _stat info;
+	if (_stat(path.c_str(), &info) != 0) {
+		return -1;
+	}
+#else
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0) {
+		return -1;
+	}
+#endif
+	return (long long)info.st_mtime;
+}
+
+static double seconds_now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+FileWatcher::FileWatcher() : inotify_fd(-1), last_scan(0) {
+#ifdef __linux__
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+	if (inotify_fd >= 0) {
+		close(inotify_fd);
+	}
+#endif
+}
+
+void FileWatcher::watch(const std::string& path, std::function<void()> on_change) {
+	WatchedFile file;
+	file.path = path;
+	size_t slash = path.find_last_of("/\\");
+	file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+	file.directory_watch = -1;
+	file.modified = modified_time(path);
+	file.changed = false;
+	file.on_change = on_change;
+
+#ifdef __linux__
+	if (inotify_fd >= 0) {
+		std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+		//Watching a directory twice returns the same descriptor
+		file.directory_watch = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	}
+#endif
+
+	files.push_back(file);
+}
+
+int FileWatcher::poll() {
+	if (files.empty()) {
+		return 0;
+	}
+
+#ifdef __linux__
+	if (inotify_fd >= 0) {
+		alignas(struct inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+			for (char* at = buffer; at < buffer + length;) {
+				const struct inotify_event* event = (const struct inotify_event*)at;
+				for (size_t i = 0; i < files.size(); i++) {
+					if (event->len > 0 && files[i].directory_watch == event->wd && files[i].name == event->name) {
+						files[i].changed = true;
+					}
+				}
+				at += sizeof(struct inotify_event) + event->len;
+			}
+		}
+	}
+#endif
+
+	//Files whose directory couldn't be watched fall back to polling their modification time
+	bool scan = false;
+	for (size_t i = 0; i < files.size(); i++) {
+		if (files[i].directory_watch < 0) {
+			scan = true;
+		}
+	}
+	if (scan && seconds_now() - last_scan >= scan_interval) {
+		last_scan = seconds_now();
+		for (size_t i = 0; i < files.size(); i++) {
+			if (files[i].directory_watch >= 0) {
+				continue;
+			}
+			long long modified = modified_time(files[i].path);
+			if (modified != files[i].modified && modified != -1) {
+				files[i].modified = modified;
+				files[i].changed = true;
+			}
+		}
+	}
+
+	int reloaded = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		if (files[i].changed) {
+			files[i].changed = false;
+			files[i].on_change();
+			reloaded += 1;
+		}
+	}
+	return reloaded;
+}
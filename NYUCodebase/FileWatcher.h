@@ -0,0 +1,44 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+//Calls back when watched files are rewritten, for reloading assets without a restart.
+//
+//	file_watcher.watch("fragment.glsl", [&]{ program->Reload(); });
+//	...
+//	file_watcher.poll(); //between frames, callbacks run here
+//
+//On Linux this reads inotify events for the files' directories, so a poll with nothing
+//changed is one non-blocking read(). Elsewhere it compares modification times twice a
+//second. Directories are watched rather than files so editors that save by writing a
+//temporary and renaming it over the original are still seen.
+class FileWatcher {
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	void watch(const std::string& path, std::function<void()> on_change);
+	//Runs the callback of every file changed since the last poll, returns how many ran
+	int poll();
+
+private:
+	FileWatcher(const FileWatcher&);
+	FileWatcher& operator=(const FileWatcher&);
+
+	struct WatchedFile {
+		std::string path;
+		std::string name; //path without its directory
+		int directory_watch;
+		long long modified;
+		bool changed;
+		std::function<void()> on_change;
+	};
+	std::vector<WatchedFile> files;
+
+	int inotify_fd;
+	double last_scan;
+};
+
+extern FileWatcher file_watcher;
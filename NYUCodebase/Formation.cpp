@@ -0,0 +1,63 @@
+#include "Formation.h"
+
+void Formation::reset(int rows_, int columns_, float origin_x, float origin_y, float spacing_x, float spacing_y) {
+	rows = rows_ < FORMATION_MAX_ROWS ? rows_ : FORMATION_MAX_ROWS;
+	columns = columns_ < FORMATION_MAX_COLUMNS ? columns_ : FORMATION_MAX_COLUMNS;
+	origin[0] = origin_x;
+	origin[1] = origin_y;
+	spacing[0] = spacing_x;
+	spacing[1] = spacing_y;
+
+	uint64_t full_row = columns == 64 ? ~0ull : (1ull << columns) - 1;
+	for (int row = 0; row < FORMATION_MAX_ROWS; row++) {
+		alive[row] = row < rows ? full_row : 0;
+		row_offset_x[row] = 0;
+		row_offset_y[row] = 0;
+	}
+}
+
+int Formation::alive_count() const {
+	int count = 0;
+	for (int row = 0; row < rows; row++) {
+		count += popcount64(alive[row]);
+	}
+	return count;
+}
+
+bool Formation::any_alive() const {
+	return alive_columns() != 0;
+}
+
+uint64_t Formation::alive_columns() const {
+	uint64_t bits = 0;
+	for (int row = 0; row < rows; row++) {
+		bits |= alive[row];
+	}
+	return bits;
+}
+
+int Formation::leftmost_column() const {
+	uint64_t bits = alive_columns();
+	return bits ? ctz64(bits) : -1;
+}
+
+int Formation::rightmost_column() const {
+	uint64_t bits = alive_columns();
+	return bits ? highest_bit64(bits) : -1;
+}
+
+int Formation::lowest_alive_in_column(int column) const {
+	for (int row = rows - 1; row >= 0; row--) {
+		if (is_alive(row, column)) {
+			return row;
+		}
+	}
+	return -1;
+}
+
+int nth_set_bit(uint64_t bits, int n) {
+	for (int i = 0; i < n; i++) {
+		bits &= bits - 1; //drop the lowest set bit
+	}
+	return ctz64(bits);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdint.h>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+#define FORMATION_MAX_ROWS 8
+#define FORMATION_MAX_COLUMNS 64
+
+//Bit helpers, the project also builds 32-bit so MSVC works on 32-bit halves
+static inline int popcount64(uint64_t bits) {
+#if defined(_MSC_VER)
+	//No __popcnt, it faults on CPUs without the POPCNT instruction
+	bits = bits - ((bits >> 1) & 0x5555555555555555ull);
+	bits = (bits & 0x3333333333333333ull) + ((bits >> 2) & 0x3333333333333333ull);
+	bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+	return (int)((bits * 0x0101010101010101ull) >> 56);
+#else
+	return __builtin_popcountll(bits);
+#endif
+}
+
+//Index of the lowest set bit, bits must not be 0
+static inline int ctz64(uint64_t bits) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long)bits)) {
+		return (int)index;
+	}
+	_BitScanForward(&index, (unsigned long)(bits >> 32));
+	return (int)index + 32;
+#else
+	return __builtin_ctzll(bits);
+#endif
+}
+
+//Index of the highest set bit, bits must not be 0
+static inline int highest_bit64(uint64_t bits) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanReverse(&index, (unsigned long)(bits >> 32))) {
+		return (int)index + 32;
+	}
+	_BitScanReverse(&index, (unsigned long)bits);
+	return (int)index;
+#else
+	return 63 - __builtin_clzll(bits);
+#endif
+}
+
+//Bits first..last set, 0 <= first <= last <= 63
+static inline uint64_t range_bits64(int first, int last) {
+	uint64_t through_last = last >= 63 ? ~0ull : (2ull << last) - 1;
+	return through_last & ~((1ull << first) - 1);
+}
+
+
+//The enemy grid. Enemy (row, column) is alive while bit `column` of alive[row] is set,
+//row 0 is the top row. Positions come from the origin instead of being stored per enemy:
+//
+//	x = origin[0] + column * spacing[0] + row_offset_x[row]
+//	y = origin[1] - row * spacing[1] + row_offset_y[row]
+struct Formation {
+	int rows = 0;
+	int columns = 0;
+	uint64_t alive[FORMATION_MAX_ROWS];
+	float origin[2];
+	float spacing[2];
+	float row_offset_x[FORMATION_MAX_ROWS];
+	float row_offset_y[FORMATION_MAX_ROWS];
+
+	//Everyone alive, no offsets
+	void reset(int rows_, int columns_, float origin_x, float origin_y, float spacing_x, float spacing_y);
+
+	float x(int row, int column) const { return origin[0] + column * spacing[0] + row_offset_x[row]; }
+	float y(int row) const { return origin[1] - row * spacing[1] + row_offset_y[row]; }
+
+	bool is_alive(int row, int column) const { return (alive[row] >> column) & 1; }
+	void kill(int row, int column) { alive[row] &= ~(1ull << column); }
+
+	int alive_count() const;
+	bool any_alive() const;
+	//Bit c set when column c has anyone left
+	uint64_t alive_columns() const;
+	//-1 when the formation is empty
+	int leftmost_column() const;
+	int rightmost_column() const;
+	//Bottom-most alive row of column, -1 if the column is empty. Only these enemies can shoot.
+	int lowest_alive_in_column(int column) const;
+};
+
+//Index of the n-th (from 0) set bit of bits, n must be below popcount64(bits)
+int nth_set_bit(uint64_t bits, int n);
@@ -0,0 +1,131 @@
+#include "FrameArena.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <new>
+
+FrameArena frame_arena(1 << 20);
+
+FrameArena::FrameArena(size_t capacity_) {
+	size = capacity_;
+	buffer = (char*)malloc(size);
+}
+
+FrameArena::~FrameArena() {
+	free_overflow();
+	free(buffer);
+}
+
+
+//Heap blocks taken when the arena is full, linked so reset() can give back any
+//that nobody deallocated (frame_sprintf never does). The link sits right in front
+//of the pointer handed out, padded so that pointer keeps the asked alignment.
+struct FrameArena::OverflowBlock {
+	OverflowBlock* prev;
+	OverflowBlock* next;
+	size_t alignment;
+};
+
+static size_t overflow_header_size(size_t alignment) {
+	if (alignment < alignof(FrameArena::OverflowBlock)) {
+		alignment = alignof(FrameArena::OverflowBlock);
+	}
+	return (sizeof(FrameArena::OverflowBlock) + alignment - 1) & ~(alignment - 1);
+}
+
+void* FrameArena::allocate_overflow(size_t bytes, size_t alignment) {
+	size_t header = overflow_header_size(alignment);
+	char* block;
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		block = (char*)::operator new(header + bytes, std::align_val_t(alignment));
+	} else {
+		block = (char*)::operator new(header + bytes);
+	}
+
+	OverflowBlock* entry = (OverflowBlock*)(block + header) - 1;
+	entry->alignment = alignment;
+	entry->prev = NULL;
+	entry->next = overflow;
+	if (overflow != NULL) {
+		overflow->prev = entry;
+	}
+	overflow = entry;
+	return block + header;
+}
+
+void FrameArena::release_overflow(OverflowBlock* entry) {
+	if (entry->prev != NULL) {
+		entry->prev->next = entry->next;
+	} else {
+		overflow = entry->next;
+	}
+	if (entry->next != NULL) {
+		entry->next->prev = entry->prev;
+	}
+
+	size_t alignment = entry->alignment;
+	char* block = (char*)(entry + 1) - overflow_header_size(alignment);
+	if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+		::operator delete(block, std::align_val_t(alignment));
+	} else {
+		::operator delete(block);
+	}
+}
+
+void FrameArena::free_overflow() {
+	while (overflow != NULL) {
+		release_overflow(overflow);
+	}
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+	uintptr_t start = ((uintptr_t)(buffer + offset) + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+	size_t new_offset = (start - (uintptr_t)buffer) + bytes;
+
+	if (new_offset > size) {
+		//Out of frame memory, keep going on the heap rather than crashing
+		overflow_count++;
+		return allocate_overflow(bytes, alignment);
+	}
+
+	offset = new_offset;
+	return (void*)start;
+}
+
+void FrameArena::deallocate(void* ptr) {
+	if (ptr != NULL && !owns(ptr)) {
+		release_overflow((OverflowBlock*)ptr - 1);
+	}
+}
+
+bool FrameArena::owns(const void* ptr) const {
+	return ptr >= buffer && ptr < buffer + size;
+}
+
+void FrameArena::reset() {
+	if (offset > high_water) {
+		high_water = offset;
+	}
+	offset = 0;
+	free_overflow();
+}
+
+
+const char* frame_sprintf(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(NULL, 0, format, args);
+	va_end(args);
+
+	if (length < 0) {
+		return "";
+	}
+
+	char* text = (char*)frame_arena.allocate(length + 1, 1);
+	va_start(args, format);
+	vsnprintf(text, length + 1, format, args);
+	va_end(args);
+	return text;
+}
+
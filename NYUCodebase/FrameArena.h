@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+//Linear (bump) allocator for data that only lives for one frame.
+//Everything handed out is released at once by reset() at the top of the main loop.
+class FrameArena {
+public:
+	FrameArena(size_t capacity_);
+	~FrameArena();
+
+	void* allocate(size_t bytes, size_t alignment);
+	void deallocate(void* ptr);
+	void reset();
+
+	bool owns(const void* ptr) const;
+
+	size_t used() const { return offset; }
+	size_t capacity() const { return size; }
+
+	//Most bytes used by a single frame since startup
+	size_t high_water = 0;
+	//Allocations that did not fit and went to the global heap instead
+	unsigned int overflow_count = 0;
+
+	struct OverflowBlock;
+
+private:
+	FrameArena(const FrameArena&);
+	FrameArena& operator=(const FrameArena&);
+
+	char* buffer;
+	size_t size;
+	size_t offset = 0;
+	OverflowBlock* overflow = NULL;
+
+	void* allocate_overflow(size_t bytes, size_t alignment);
+	void release_overflow(OverflowBlock* entry);
+	void free_overflow();
+};
+
+extern FrameArena frame_arena;
+
+
+//STL allocator backed by frame_arena, deallocate is a no-op until the arena resets
+template <class T>
+class FrameAllocator {
+public:
+	typedef T value_type;
+
+	FrameAllocator() {}
+	template <class U> FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t n){
+		return (T*)frame_arena.allocate(n * sizeof(T), alignof(T));
+	}
+
+	void deallocate(T* ptr, size_t){
+		frame_arena.deallocate(ptr);
+	}
+};
+
+template <class T, class U>
+bool operator==(const FrameAllocator<T>&, const FrameAllocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const FrameAllocator<T>&, const FrameAllocator<U>&) { return false; }
+
+
+template <class T>
+using frame_vector = std::vector<T, FrameAllocator<T>>;
+
+//printf into arena memory, the result is valid until the end of the frame
+const char* frame_sprintf(const char* format, ...);
+
@@ -0,0 +1,79 @@
+#include "FramePacer.h"
+#include "Profiler.h"
+#include <iostream>
+
+FramePacer frame_pacer;
+
+//SDL_Delay can overshoot by a scheduler tick, the last stretch before a deadline is spun
+#define FRAME_PACER_SPIN_MS 2
+
+VsyncMode FramePacer::set_vsync(VsyncMode requested) {
+	vsync_mode = requested;
+	while (SDL_GL_SetSwapInterval(vsync_mode) != 0 && vsync_mode != VSYNC_OFF) {
+		std::cout << "Swap interval " << vsync_mode << " not supported: " << SDL_GetError() << std::endl;
+		vsync_mode = vsync_mode == VSYNC_ADAPTIVE ? VSYNC_ON : VSYNC_OFF;
+	}
+	deadline = 0;
+	return vsync_mode;
+}
+
+void FramePacer::set_target_fps(int fps_) {
+	fps = fps_ > 0 ? fps_ : 0;
+	period = fps > 0 ? SDL_GetPerformanceFrequency() / fps : 0;
+	deadline = 0;
+}
+
+void FramePacer::note_input(const SDL_Event& event) {
+	bool is_input = (event.type == SDL_KEYDOWN && !event.key.repeat) ||
+		event.type == SDL_MOUSEBUTTONDOWN ||
+		event.type == SDL_JOYBUTTONDOWN ||
+		event.type == SDL_CONTROLLERBUTTONDOWN;
+
+	//Keep the oldest event, it has waited the longest
+	if (is_input && !input_pending) {
+		input_pending = true;
+		input_timestamp = event.common.timestamp;
+	}
+}
+
+void FramePacer::wait_for_deadline() {
+	if (vsync_mode != VSYNC_OFF || period == 0) {
+		return;
+	}
+
+	PROFILE_ZONE("FramePacer::wait_for_deadline");
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	//First frame, or more than a frame late (a hitch or an idle screen): start over from now
+	//rather than rushing out frames to catch up
+	if (deadline == 0 || now > deadline + period) {
+		deadline = now + period;
+		return;
+	}
+
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 spin = frequency * FRAME_PACER_SPIN_MS / 1000;
+	if (deadline > now + spin) {
+		SDL_Delay((Uint32)((deadline - now - spin) * 1000 / frequency));
+	}
+	while (SDL_GetPerformanceCounter() < deadline) {
+	}
+
+	deadline += period;
+}
+
+void FramePacer::frame_presented() {
+	if (input_pending) {
+		latency_ms.add((float)(SDL_GetTicks() - input_timestamp));
+		input_pending = false;
+	}
+}
+
+int display_refresh_rate(SDL_Window* window) {
+	SDL_DisplayMode display_mode;
+	int display = SDL_GetWindowDisplayIndex(window);
+	if (display < 0 || SDL_GetCurrentDisplayMode(display, &display_mode) != 0 || display_mode.refresh_rate <= 0) {
+		return 60;
+	}
+	return display_mode.refresh_rate;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL.h>
+#include "PerfStats.h"
+
+//Values are the SDL_GL_SetSwapInterval arguments
+enum VsyncMode { VSYNC_ADAPTIVE = -1, VSYNC_OFF = 0, VSYNC_ON = 1 };
+
+//Frame pacing: picks the swap interval, and with vsync off sleeps until each
+//frame's deadline so frames come out evenly instead of as fast as possible.
+//Also measures input-to-present latency, from the SDL timestamp of the first
+//input event handled in a frame to the return of that frame's swap.
+//
+//	frame_pacer.set_vsync(VSYNC_ADAPTIVE);
+//	frame_pacer.wait_for_deadline(); //before input, so render and swap follow it directly
+//	...poll events, frame_pacer.note_input(event) for each...
+//	SDL_GL_SwapWindow(window);
+//	frame_pacer.frame_presented();
+class FramePacer {
+public:
+	//Falls back adaptive -> on -> off as drivers refuse, returns the mode in effect
+	VsyncMode set_vsync(VsyncMode requested);
+	VsyncMode vsync() const { return vsync_mode; }
+
+	//Frame rate for the limiter when vsync is off, 0 runs unlimited
+	void set_target_fps(int fps);
+	int target_fps() const { return fps; }
+
+	void note_input(const SDL_Event& event);
+	//Sleeps until the next deadline, does nothing while vsync paces the swap
+	void wait_for_deadline();
+	void frame_presented();
+
+	//Input-to-present latency in milliseconds, one sample per frame that handled input
+	const RollingHistogram& input_latency_ms() const { return latency_ms; }
+
+private:
+	VsyncMode vsync_mode = VSYNC_OFF;
+	int fps = 0;
+	Uint64 period = 0; //performance counter ticks per frame
+	Uint64 deadline = 0;
+
+	bool input_pending = false;
+	Uint32 input_timestamp = 0;
+	RollingHistogram latency_ms;
+};
+
+extern FramePacer frame_pacer;
+
+//Refresh rate of the display showing window, 60 when SDL can't tell
+int display_refresh_rate(SDL_Window* window);
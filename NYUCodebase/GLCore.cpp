@@ -0,0 +1,52 @@
+#include "GLCore.h"
+#include "PerfStats.h"
+
+VertexStream* vertex_stream = NULL;
+
+static GLuint vertex_array = 0;
+static GLuint quad_indices = 0;
+
+void gl_core_init() {
+	glGenVertexArrays(1, &vertex_array);
+	glBindVertexArray(vertex_array);
+
+	//The element array binding is part of the vertex array object, so this stays bound for every draw
+	const GLushort indices[6] = { 0, 1, 2, 0, 2, 3 };
+	glGenBuffers(1, &quad_indices);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_indices);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	vertex_stream = new VertexStream();
+}
+
+void gl_core_cleanup() {
+	delete vertex_stream;
+	vertex_stream = NULL;
+	glDeleteBuffers(1, &quad_indices);
+	glDeleteVertexArrays(1, &vertex_array);
+}
+
+void draw_indexed_quad() {
+	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (void*)0);
+}
+
+
+VertexStream::VertexStream() {
+	glGenBuffers(1, &vbo);
+}
+
+VertexStream::~VertexStream() {
+	glDeleteBuffers(1, &vbo);
+}
+
+void VertexStream::upload(const float* first, size_t first_count, const float* second, size_t second_count) {
+	second_offset = first_count * sizeof(float);
+	size_t total = second_offset + second_count * sizeof(float);
+
+	GL_STATE(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+	GL_UPLOAD(glBufferData(GL_ARRAY_BUFFER, total, NULL, GL_STREAM_DRAW));
+	GL_UPLOAD(glBufferSubData(GL_ARRAY_BUFFER, 0, second_offset, first));
+	if (second_count > 0) {
+		GL_UPLOAD(glBufferSubData(GL_ARRAY_BUFFER, second_offset, second_count * sizeof(float), second));
+	}
+}
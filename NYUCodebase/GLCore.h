@@ -0,0 +1,47 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <stddef.h>
+
+//State the renderer needs to run on a GL 3.3 core context, where client-side vertex
+//arrays, GL_QUADS and GL_CLAMP are gone and drawing without a vertex array object
+//bound is an error. It all works the same on compatibility contexts.
+//
+//gl_core_init() runs once after the context is made current. It binds the vertex
+//array object every draw uses and the index buffer for draw_indexed_quad().
+
+void gl_core_init();
+//Frees what gl_core_init() made, while the context is still current
+void gl_core_cleanup();
+
+//Two triangles over a 4 vertex quad given in order top left, bottom left, bottom right, top right
+void draw_indexed_quad();
+
+//Streams small per-draw vertex arrays to the GPU in place of client-side pointers.
+//upload() orphans the previous contents, so it never waits on draws still reading them.
+//
+//	vertex_stream.upload(positions, 12, tex_coords, 12);
+//	glVertexAttribPointer(position, 2, GL_FLOAT, false, 0, vertex_stream.offset(0));
+//	glVertexAttribPointer(tex_coord, 2, GL_FLOAT, false, 0, vertex_stream.offset(1));
+class VertexStream {
+public:
+	VertexStream();
+	~VertexStream();
+
+	//Places the arrays back to back and leaves the buffer bound to GL_ARRAY_BUFFER
+	void upload(const float* first, size_t first_count, const float* second = NULL, size_t second_count = 0);
+	//Attribute pointer for the first (0) or second (1) array of the last upload
+	const void* offset(int array) const { return (const void*)(array == 0 ? 0 : second_offset); }
+
+private:
+	VertexStream(const VertexStream&);
+	VertexStream& operator=(const VertexStream&);
+
+	GLuint vbo = 0;
+	size_t second_offset = 0;
+};
+
+extern VertexStream* vertex_stream;
@@ -0,0 +1,286 @@
+#include "GoldenImage.h"
+#include "stb_image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+//PNG output is a single fixed-Huffman deflate block. Game frames are mostly flat
+//background, so matching against the previous pixel and the row above gets most of
+//what a full zlib would, without the dynamic Huffman tables.
+
+struct BitWriter {
+	std::vector<unsigned char>* out;
+	unsigned int bits;
+	int count;
+
+	void write(unsigned int value, int length) {
+		bits |= value << count;
+		count += length;
+		while (count >= 8) {
+			out->push_back((unsigned char)bits);
+			bits >>= 8;
+			count -= 8;
+		}
+	}
+
+	//Huffman codes are stored most significant bit first
+	void write_code(unsigned int code, int length) {
+		unsigned int reversed = 0;
+		for (int i = 0; i < length; i++) {
+			reversed = (reversed << 1) | ((code >> i) & 1);
+		}
+		write(reversed, length);
+	}
+
+	void flush() {
+		if (count > 0) {
+			out->push_back((unsigned char)bits);
+		}
+		bits = 0;
+		count = 0;
+	}
+};
+
+static const int length_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const int length_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const int distance_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const int distance_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+static void write_literal(BitWriter* writer, int symbol) {
+	if (symbol < 144) {
+		writer->write_code(0x30 + symbol, 8);
+	} else if (symbol < 256) {
+		writer->write_code(0x190 + symbol - 144, 9);
+	} else if (symbol < 280) {
+		writer->write_code(symbol - 256, 7);
+	} else {
+		writer->write_code(0xc0 + symbol - 280, 8);
+	}
+}
+
+static void write_match(BitWriter* writer, int length, int distance) {
+	int code = 28;
+	while (length_base[code] > length) {
+		code--;
+	}
+	write_literal(writer, 257 + code);
+	writer->write(length - length_base[code], length_extra[code]);
+
+	code = 29;
+	while (distance_base[code] > distance) {
+		code--;
+	}
+	writer->write_code(code, 5);
+	writer->write(distance - distance_base[code], distance_extra[code]);
+}
+
+static int match_length(const unsigned char* data, size_t size, size_t position, size_t distance) {
+	if (distance == 0 || distance > position || distance > 32768) {
+		return 0;
+	}
+	size_t limit = size - position < 258 ? size - position : 258;
+	size_t length = 0;
+	while (length < limit && data[position + length] == data[position + length - distance]) {
+		length++;
+	}
+	return (int)length;
+}
+
+//zlib stream (RFC 1950) wrapping one deflate block (RFC 1951). Candidate matches are
+//the last position with the same three bytes, one pixel back and one row back.
+static void zlib_compress(const unsigned char* data, size_t size, size_t row_bytes, std::vector<unsigned char>* out) {
+	const int hash_bits = 15;
+	std::vector<size_t> last_seen((size_t)1 << hash_bits, (size_t)-1);
+	BitWriter writer = { out, 0, 0 };
+
+	out->push_back(0x78);
+	out->push_back(0x01);
+	writer.write(1, 1); //final block
+	writer.write(1, 2); //fixed Huffman codes
+
+	size_t position = 0;
+	while (position < size) {
+		int best_length = 0;
+		size_t best_distance = 0;
+		if (position + 3 <= size) {
+			unsigned int hash = ((data[position] << 16) | (data[position + 1] << 8) | data[position + 2]) * 2654435761u >> (32 - hash_bits);
+			size_t candidates[3] = { last_seen[hash] == (size_t)-1 ? 0 : position - last_seen[hash], 3, row_bytes };
+			last_seen[hash] = position;
+			for (int i = 0; i < 3; i++) {
+				int length = match_length(data, size, position, candidates[i]);
+				if (length > best_length) {
+					best_length = length;
+					best_distance = candidates[i];
+				}
+			}
+		}
+		if (best_length >= 3) {
+			write_match(&writer, best_length, (int)best_distance);
+			position += best_length;
+		} else {
+			write_literal(&writer, data[position]);
+			position++;
+		}
+	}
+	write_literal(&writer, 256);
+	writer.flush();
+
+	unsigned int a = 1, b = 0;
+	for (size_t i = 0; i < size; i++) {
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	unsigned int adler = (b << 16) | a;
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out->push_back((unsigned char)(adler >> shift));
+	}
+}
+
+static unsigned int crc32(const unsigned char* data, size_t size, unsigned int crc) {
+	static unsigned int table[256];
+	if (table[1] == 0) {
+		for (unsigned int n = 0; n < 256; n++) {
+			unsigned int c = n;
+			for (int k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+	}
+	for (size_t i = 0; i < size; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+static void put_u32(std::vector<unsigned char>* out, unsigned int value) {
+	for (int shift = 24; shift >= 0; shift -= 8) {
+		out->push_back((unsigned char)(value >> shift));
+	}
+}
+
+static void write_chunk(FILE* file, const char* type, const std::vector<unsigned char>& data) {
+	std::vector<unsigned char> chunk;
+	put_u32(&chunk, (unsigned int)data.size());
+	chunk.insert(chunk.end(), type, type + 4);
+	chunk.insert(chunk.end(), data.begin(), data.end());
+	put_u32(&chunk, crc32(&chunk[4], chunk.size() - 4, 0xffffffffu) ^ 0xffffffffu);
+	fwrite(&chunk[0], 1, chunk.size(), file);
+}
+
+bool write_png(const char* path, int width, int height, const unsigned char* rgb) {
+	//Every row gets filter type 0, the matcher already finds the row above
+	size_t row_bytes = (size_t)width * 3 + 1;
+	std::vector<unsigned char> filtered(row_bytes * height);
+	for (int y = 0; y < height; y++) {
+		filtered[y * row_bytes] = 0;
+		memcpy(&filtered[y * row_bytes + 1], rgb + (size_t)y * width * 3, width * 3);
+	}
+
+	std::vector<unsigned char> header;
+	put_u32(&header, width);
+	put_u32(&header, height);
+	header.push_back(8); //bit depth
+	header.push_back(2); //truecolor
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	std::vector<unsigned char> compressed;
+	zlib_compress(&filtered[0], filtered.size(), row_bytes, &compressed);
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+	static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	fwrite(signature, 1, sizeof(signature), file);
+	write_chunk(file, "IHDR", header);
+	write_chunk(file, "IDAT", compressed);
+	write_chunk(file, "IEND", std::vector<unsigned char>());
+	bool written = ferror(file) == 0;
+	fclose(file);
+	return written;
+}
+
+bool read_png(const char* path, int* width, int* height, std::vector<unsigned char>* rgb) {
+	int components;
+	unsigned char* image = stbi_load(path, width, height, &components, STBI_rgb);
+	if (image == NULL) {
+		return false;
+	}
+	rgb->assign(image, image + (size_t)*width * *height * 3);
+	stbi_image_free(image);
+	return true;
+}
+
+ImageDiff compare_images(const unsigned char* expected, const unsigned char* actual, int pixel_count, int tolerance) {
+	ImageDiff diff = { 0, 0 };
+	for (int i = 0; i < pixel_count; i++) {
+		int pixel_difference = 0;
+		for (int channel = 0; channel < 3; channel++) {
+			int difference = abs((int)expected[i * 3 + channel] - (int)actual[i * 3 + channel]);
+			if (difference > pixel_difference) {
+				pixel_difference = difference;
+			}
+		}
+		if (pixel_difference > tolerance) {
+			diff.differing_pixels += 1;
+		}
+		if (pixel_difference > diff.max_channel_difference) {
+			diff.max_channel_difference = pixel_difference;
+		}
+	}
+	return diff;
+}
+
+void downsample_image(const unsigned char* rgb, int width, int height, int factor, std::vector<unsigned char>* out) {
+	int out_width = width / factor;
+	int out_height = height / factor;
+	out->resize((size_t)out_width * out_height * 3);
+	for (int y = 0; y < out_height; y++) {
+		for (int x = 0; x < out_width; x++) {
+			for (int channel = 0; channel < 3; channel++) {
+				int sum = 0;
+				for (int sy = 0; sy < factor; sy++) {
+					const unsigned char* row = rgb + ((size_t)(y * factor + sy) * width + x * factor) * 3;
+					for (int sx = 0; sx < factor; sx++) {
+						sum += row[sx * 3 + channel];
+					}
+				}
+				(*out)[((size_t)y * out_width + x) * 3 + channel] = (unsigned char)((sum + factor * factor / 2) / (factor * factor));
+			}
+		}
+	}
+}
+
+void make_diff_image(const unsigned char* expected, const unsigned char* actual, int pixel_count, int tolerance, std::vector<unsigned char>* diff) {
+	diff->resize((size_t)pixel_count * 3);
+	for (int i = 0; i < pixel_count; i++) {
+		bool differs = false;
+		for (int channel = 0; channel < 3; channel++) {
+			if (abs((int)expected[i * 3 + channel] - (int)actual[i * 3 + channel]) > tolerance) {
+				differs = true;
+			}
+		}
+		for (int channel = 0; channel < 3; channel++) {
+			(*diff)[i * 3 + channel] = differs ? (channel == 0 ? 255 : 0) : expected[i * 3 + channel] / 4;
+		}
+	}
+}
+
+bool make_directory(const char* path) {
+#ifdef _WIN32
+	int result = _mkdir(path);
+#else
+	int result = mkdir(path, 0755);
+#endif
+	return result == 0 || errno == EEXIST;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+//Frame comparison for --render-test. Images are 8 bit RGB PNG, 3 bytes per pixel,
+//top row first. They are written here and read back through stb_image, mostly flat
+//game frames compress to a few kilobytes so the goldens can live in the repo.
+
+bool write_png(const char* path, int width, int height, const unsigned char* rgb);
+bool read_png(const char* path, int* width, int* height, std::vector<unsigned char>* rgb);
+
+struct ImageDiff {
+	int differing_pixels; //pixels with any channel off by more than the tolerance
+	int max_channel_difference;
+};
+
+ImageDiff compare_images(const unsigned char* expected, const unsigned char* actual, int pixel_count, int tolerance);
+
+//Averages each factor x factor block into one pixel, a trailing partial block is dropped
+void downsample_image(const unsigned char* rgb, int width, int height, int factor, std::vector<unsigned char>* out);
+
+//The expected image dimmed, with pixels that differ by more than tolerance in red
+void make_diff_image(const unsigned char* expected, const unsigned char* actual, int pixel_count, int tolerance, std::vector<unsigned char>* diff);
+
+//Creates path if it doesn't exist, parent directories must
+bool make_directory(const char* path);
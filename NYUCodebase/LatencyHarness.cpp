@@ -0,0 +1,163 @@
+#include "LatencyHarness.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+LatencyHarness latency_harness;
+
+//A probe that hasn't reached the screen by then counts as dropped
+#define LATENCY_PROBE_TIMEOUT_MS 1000
+//Presses dropped back to back before the run gives up, the key is clearly not being handled
+#define LATENCY_MAX_DROPPED_IN_A_ROW 5
+//Gap before the next press, random so presses don't lock to the frame rate
+#define LATENCY_PROBE_MIN_GAP_MS 30
+#define LATENCY_PROBE_MAX_GAP_MS 120
+
+static float counter_to_ms(Uint64 ticks) {
+	return (float)((double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency());
+}
+
+static float percentile(std::vector<float> samples, float fraction) {
+	if (samples.empty()) {
+		return 0;
+	}
+	std::sort(samples.begin(), samples.end());
+	int index = (int)(fraction * (samples.size() - 1) + 0.5f);
+	return samples[index];
+}
+
+static float average(const std::vector<float>& samples) {
+	float total = 0;
+	for (size_t i = 0; i < samples.size(); i++) {
+		total += samples[i];
+	}
+	return samples.empty() ? 0 : total / samples.size();
+}
+
+bool LatencyHarness::start(SDL_Keycode key_, int probe_count_) {
+	key = key_;
+	probe_count = probe_count_;
+	dropped = 0;
+	dropped_in_a_row = 0;
+	stop_reason = NULL;
+	handled_ms.clear();
+	presented_ms.clear();
+	handled_ms.reserve(probe_count);
+	presented_ms.reserve(probe_count);
+	running = true;
+	schedule_probe();
+	return running;
+}
+
+bool LatencyHarness::finished() const {
+	return (int)presented_ms.size() >= probe_count || dropped > probe_count || stop_reason != NULL;
+}
+
+void LatencyHarness::stop(const char* reason) {
+	if (stop_reason == NULL) {
+		stop_reason = reason;
+	}
+}
+
+void LatencyHarness::schedule_probe() {
+	state.store(PROBE_SCHEDULED);
+	Uint32 gap = LATENCY_PROBE_MIN_GAP_MS + rand() % (LATENCY_PROBE_MAX_GAP_MS - LATENCY_PROBE_MIN_GAP_MS + 1);
+	if (SDL_AddTimer(gap, inject, this) == 0) {
+		printf("Unable to start the latency probe timer: %s\n", SDL_GetError());
+		running = false;
+	}
+}
+
+//Runs on SDL's timer thread
+Uint32 LatencyHarness::inject(Uint32, void* param) {
+	LatencyHarness* harness = (LatencyHarness*)param;
+
+	SDL_Event event;
+	SDL_memset(&event, 0, sizeof(event));
+	event.type = SDL_KEYDOWN;
+	event.key.state = SDL_PRESSED;
+	event.key.keysym.sym = harness->key;
+	event.key.keysym.scancode = SDL_GetScancodeFromKey(harness->key);
+
+	harness->pushed_at.store(SDL_GetPerformanceCounter());
+	harness->state.store(PROBE_IN_FLIGHT);
+	SDL_PushEvent(&event);
+
+	event.type = SDL_KEYUP;
+	event.key.state = SDL_RELEASED;
+	SDL_PushEvent(&event);
+
+	return 0; //one shot, the next probe is scheduled once this one completes
+}
+
+void LatencyHarness::input_reflected(SDL_Keycode pressed) {
+	if (running && pressed == key && state.load() == PROBE_IN_FLIGHT) {
+		reflected_at = SDL_GetPerformanceCounter();
+		state.store(PROBE_REFLECTED);
+	}
+}
+
+void LatencyHarness::frame_presented() {
+	if (!running || finished()) {
+		return;
+	}
+
+	Uint64 now = SDL_GetPerformanceCounter();
+	int current = state.load();
+	if (current == PROBE_REFLECTED) {
+		Uint64 pushed = pushed_at.load();
+		handled_ms.push_back(counter_to_ms(reflected_at - pushed));
+		presented_ms.push_back(counter_to_ms(now - pushed));
+		dropped_in_a_row = 0;
+		schedule_probe();
+	}
+	else if (current == PROBE_IN_FLIGHT && counter_to_ms(now - pushed_at.load()) > LATENCY_PROBE_TIMEOUT_MS) {
+		dropped++;
+		dropped_in_a_row++;
+		if (dropped_in_a_row >= LATENCY_MAX_DROPPED_IN_A_ROW) {
+			stop("presses stopped reaching the screen");
+			return;
+		}
+		schedule_probe();
+	}
+}
+
+void LatencyHarness::print() const {
+	printf("input latency over %d probes (%d dropped)\n", (int)presented_ms.size(), dropped);
+	if (stop_reason != NULL) {
+		printf("stopped early after %d of %d probes: %s\n", (int)presented_ms.size(), probe_count, stop_reason);
+	}
+	printf("%-24s %8s %8s %8s %8s\n", "", "avg ms", "p50 ms", "p99 ms", "max ms");
+	printf("%-24s %8.2f %8.2f %8.2f %8.2f\n", "push to handled", average(handled_ms), percentile(handled_ms, 0.5f), percentile(handled_ms, 0.99f), percentile(handled_ms, 1.0f));
+	printf("%-24s %8.2f %8.2f %8.2f %8.2f\n", "push to present", average(presented_ms), percentile(presented_ms, 0.5f), percentile(presented_ms, 0.99f), percentile(presented_ms, 1.0f));
+}
+
+bool LatencyHarness::write_json(const char* path) const {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	//1 ms buckets of push to present
+	int buckets = (int)percentile(presented_ms, 1.0f) + 1;
+	std::vector<int> histogram(buckets, 0);
+	for (size_t i = 0; i < presented_ms.size(); i++) {
+		histogram[(int)presented_ms[i]]++;
+	}
+
+	fprintf(file, "{\n  \"probes\": %d,\n  \"dropped\": %d,\n", (int)presented_ms.size(), dropped);
+	if (stop_reason != NULL) {
+		fprintf(file, "  \"stopped_early\": \"%s\",\n", stop_reason);
+	}
+	fprintf(file, "  \"handled_ms\": {\"avg\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+		average(handled_ms), percentile(handled_ms, 0.5f), percentile(handled_ms, 0.99f), percentile(handled_ms, 1.0f));
+	fprintf(file, "  \"presented_ms\": {\"avg\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f},\n",
+		average(presented_ms), percentile(presented_ms, 0.5f), percentile(presented_ms, 0.99f), percentile(presented_ms, 1.0f));
+	fprintf(file, "  \"presented_histogram_ms\": [");
+	for (int i = 0; i < buckets; i++) {
+		fprintf(file, "%d%s", histogram[i], i + 1 < buckets ? ", " : "");
+	}
+	fprintf(file, "]\n}\n");
+	fclose(file);
+	return true;
+}
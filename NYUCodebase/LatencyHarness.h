@@ -0,0 +1,60 @@
+#pragma once
+
+#include <SDL.h>
+#include <atomic>
+#include <vector>
+
+//Unattended input-to-photon measurement. An SDL timer injects one synthetic key
+//press at a time with SDL_PushEvent and stamps it with the performance counter,
+//so presses land at random points of the frame like real input does.
+//The game calls input_reflected() where the press changes game state, which tags
+//the current frame, and frame_presented() after every swap, which completes the
+//probe with that frame's swap time.
+//
+//	latency_harness.start(SDLK_SPACE, 200);
+//	...on the key: latency_harness.input_reflected(SDLK_SPACE);
+//	...after SDL_GL_SwapWindow: latency_harness.frame_presented();
+//	if (latency_harness.finished()) latency_harness.write_json(path);
+//
+//Only event-driven input can be probed, SDL_PushEvent does not update SDL_GetKeyboardState.
+class LatencyHarness {
+public:
+	//Needs SDL_INIT_TIMER
+	bool start(SDL_Keycode key_, int probe_count_);
+	bool active() const { return running; }
+	//All probes are in, too many presses never showed up on screen, or stop() was called
+	bool finished() const;
+	//Ends the run early with whatever probes are in, e.g. when the level the probes
+	//act on is gone. reason must outlive the harness, it ends up in print and the json.
+	void stop(const char* reason);
+
+	void input_reflected(SDL_Keycode pressed);
+	void frame_presented();
+
+	void print() const;
+	bool write_json(const char* path) const;
+
+private:
+	enum ProbeState { PROBE_SCHEDULED, PROBE_IN_FLIGHT, PROBE_REFLECTED };
+
+	static Uint32 inject(Uint32, void* param);
+	void schedule_probe();
+
+	SDL_Keycode key = 0;
+	int probe_count = 0;
+	bool running = false;
+	int dropped = 0;
+	int dropped_in_a_row = 0;
+	const char* stop_reason = NULL;
+
+	//Written by the timer thread, then handed over through state
+	std::atomic<int> state{ PROBE_SCHEDULED };
+	std::atomic<Uint64> pushed_at{ 0 };
+	Uint64 reflected_at = 0;
+
+	//Milliseconds from push to the frame that acted on it, and to that frame's swap
+	std::vector<float> handled_ms;
+	std::vector<float> presented_ms;
+};
+
+extern LatencyHarness latency_harness;
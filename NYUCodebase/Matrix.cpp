@@ -1,10 +1,15 @@
 
 #include "Matrix.h"
 #include <math.h>
+#ifdef MATRIX_SSE
+    #include <emmintrin.h>
+#endif
 
-Matrix::Matrix() {
-    Identity();
-}
+static_assert(Matrix().m[0][0] == 1.0f && Matrix().m[3][0] == 0.0f, "constexpr identity");
+static_assert(Matrix::Translation(1.0f, 2.0f, 3.0f).m[3][1] == 2.0f, "constexpr translation");
+static_assert(Matrix::OrthoProjection(-2.0f, 2.0f, -1.0f, 1.0f, -1.0f, 1.0f).m[0][0] == 0.5f, "constexpr ortho x scale");
+static_assert(Matrix::OrthoProjection(-2.0f, 2.0f, -1.0f, 1.0f, -1.0f, 1.0f).m[2][2] == -1.0f, "constexpr ortho z scale");
+static_assert(Matrix::OrthoProjection(0.0f, 4.0f, 0.0f, 2.0f, -1.0f, 1.0f).m[3][0] == -1.0f, "constexpr ortho x offset");
 
 void Matrix::Identity() {
     m[0][0] = 1.0;
@@ -28,7 +33,7 @@ void Matrix::Identity() {
     m[3][3] = 1.0;
 }
 
-Matrix Matrix::Inverse() const {
+Matrix Matrix::InverseScalar() const {
     float m00 = m[0][0], m01 = m[0][1], m02 = m[0][2], m03 = m[0][3];
     float m10 = m[1][0], m11 = m[1][1], m12 = m[1][2], m13 = m[1][3];
     float m20 = m[2][0], m21 = m[2][1], m22 = m[2][2], m23 = m[2][3];
@@ -102,7 +107,7 @@ Matrix Matrix::Inverse() const {
     return m2;
 }
 
-Matrix Matrix::operator * (const Matrix &m2) const {
+Matrix Matrix::MultiplyScalar(const Matrix &m2) const {
     Matrix r;
     
     r.m[0][0] = m[0][0] * m2.m[0][0] + m[0][1] * m2.m[1][0] + m[0][2] * m2.m[2][0] + m[0][3] * m2.m[3][0];
@@ -128,16 +133,142 @@ Matrix Matrix::operator * (const Matrix &m2) const {
     return r;
 }
 
+#ifdef MATRIX_SSE
+
+//_MM_SHUFFLE takes lanes high to low, these take them low to high
+#define SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define SWIZZLE(v, x, y, z, w) SHUFFLE(v, v, x, y, z, w)
+#define SPLAT(v, i) SWIZZLE(v, i, i, i, i)
+
+//The 2x2 helpers below work on 2x2 row-major matrices packed as (a b c d)
+
+//A * B
+static inline __m128 Mat2Mul(__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+//adj(A) * B
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
+}
+
+//A * adj(B)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
+}
+
+//Each row of the result is a linear combination of the rows of m2
+Matrix Matrix::operator * (const Matrix &m2) const {
+    __m128 b0 = _mm_load_ps(m2.m[0]);
+    __m128 b1 = _mm_load_ps(m2.m[1]);
+    __m128 b2 = _mm_load_ps(m2.m[2]);
+    __m128 b3 = _mm_load_ps(m2.m[3]);
+    
+    Matrix r;
+    for (int i = 0; i < 4; i++) {
+        __m128 row = _mm_mul_ps(_mm_set1_ps(m[i][0]), b0);
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][1]), b1));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][2]), b2));
+        row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(m[i][3]), b3));
+        _mm_store_ps(r.m[i], row);
+    }
+    return r;
+}
+
+//Block-wise inverse on the four 2x2 sub-matrices
+//    | A B |
+//    | C D |
+Matrix Matrix::Inverse() const {
+    __m128 r0 = _mm_load_ps(m[0]);
+    __m128 r1 = _mm_load_ps(m[1]);
+    __m128 r2 = _mm_load_ps(m[2]);
+    __m128 r3 = _mm_load_ps(m[3]);
+    
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+    
+    //(|A| |B| |C| |D|)
+    __m128 detSub = _mm_sub_ps(_mm_mul_ps(SHUFFLE(r0, r2, 0, 2, 0, 2), SHUFFLE(r1, r3, 1, 3, 1, 3)),
+                               _mm_mul_ps(SHUFFLE(r0, r2, 1, 3, 1, 3), SHUFFLE(r1, r3, 0, 2, 0, 2)));
+    __m128 detA = SPLAT(detSub, 0);
+    __m128 detB = SPLAT(detSub, 1);
+    __m128 detC = SPLAT(detSub, 2);
+    __m128 detD = SPLAT(detSub, 3);
+    
+    __m128 D_C = Mat2AdjMul(D, C);
+    __m128 A_B = Mat2AdjMul(A, B);
+    
+    //Adjugates of the result blocks
+    __m128 X_ = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+    __m128 W_ = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+    __m128 Y_ = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+    __m128 Z_ = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+    
+    //|M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 tr = _mm_mul_ps(A_B, SWIZZLE(D_C, 0, 2, 1, 3));
+    tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 1, 0, 0, 0));
+    tr = SPLAT(tr, 0);
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+    
+    __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X_ = _mm_mul_ps(X_, rDetM);
+    Y_ = _mm_mul_ps(Y_, rDetM);
+    Z_ = _mm_mul_ps(Z_, rDetM);
+    W_ = _mm_mul_ps(W_, rDetM);
+    
+    Matrix r;
+    _mm_store_ps(r.m[0], SHUFFLE(X_, Y_, 3, 1, 3, 1));
+    _mm_store_ps(r.m[1], SHUFFLE(X_, Y_, 2, 0, 2, 0));
+    _mm_store_ps(r.m[2], SHUFFLE(Z_, W_, 3, 1, 3, 1));
+    _mm_store_ps(r.m[3], SHUFFLE(Z_, W_, 2, 0, 2, 0));
+    return r;
+}
+
+void Matrix::TransformVector(const float in[4], float out[4]) const {
+    __m128 v = _mm_mul_ps(_mm_set1_ps(in[0]), _mm_load_ps(m[0]));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(in[1]), _mm_load_ps(m[1])));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(in[2]), _mm_load_ps(m[2])));
+    v = _mm_add_ps(v, _mm_mul_ps(_mm_set1_ps(in[3]), _mm_load_ps(m[3])));
+    _mm_storeu_ps(out, v);
+}
+
+#else
+
+Matrix Matrix::operator * (const Matrix &m2) const {
+    return MultiplyScalar(m2);
+}
+
+Matrix Matrix::Inverse() const {
+    return InverseScalar();
+}
+
+void Matrix::TransformVector(const float in[4], float out[4]) const {
+    float x = in[0], y = in[1], z = in[2], w = in[3];
+    for (int j = 0; j < 4; j++) {
+        out[j] = x * m[0][j] + y * m[1][j] + z * m[2][j] + w * m[3][j];
+    }
+}
+
+#endif
+
 void Matrix::SetPosition(float x, float y, float z) {
     m[3][0] = x;
     m[3][1] = y;
     m[3][2] = z;
 }
 
+//Same as multiplying by a translation matrix on the left, but only the
+//last row changes so the rest of the multiply is skipped
 void Matrix::Translate(float x, float y, float z) {
-    Matrix transMatrix;
-    transMatrix.SetPosition(x, y, z);
-    (*this) = transMatrix * (*this);
+    for (int j = 0; j < 4; j++) {
+        m[3][j] += x * m[0][j] + y * m[1][j] + z * m[2][j];
+    }
 }
 
 void Matrix::SetRotation(float rotation) {
@@ -156,9 +287,14 @@ void Matrix::Rotate(float rotation) {
 }
 
 void Matrix::Roll(float roll) {
-    Matrix rollMatrix;
-    rollMatrix.SetRoll(roll);
-    (*this) = rollMatrix * (*this);
+    float c = cos(roll);
+    float s = sin(roll);
+    for (int j = 0; j < 4; j++) {
+        float r0 = m[0][j];
+        float r1 = m[1][j];
+        m[0][j] = c * r0 + s * r1;
+        m[1][j] = c * r1 - s * r0;
+    }
 }
 
 void Matrix::SetPitch(float pitch) {
@@ -176,15 +312,25 @@ void Matrix::SetYaw(float yaw) {
 }
 
 void Matrix::Pitch(float pitch) {
-    Matrix pitchMatrix;
-    pitchMatrix.SetPitch(pitch);
-    (*this) = pitchMatrix * (*this);
+    float c = cos(pitch);
+    float s = sin(pitch);
+    for (int j = 0; j < 4; j++) {
+        float r1 = m[1][j];
+        float r2 = m[2][j];
+        m[1][j] = c * r1 + s * r2;
+        m[2][j] = c * r2 - s * r1;
+    }
 }
 
 void Matrix::Yaw(float yaw) {
-    Matrix yawMatrix;
-    yawMatrix.SetYaw(yaw);
-    (*this) = yawMatrix * (*this);
+    float c = cos(yaw);
+    float s = sin(yaw);
+    for (int j = 0; j < 4; j++) {
+        float r0 = m[0][j];
+        float r2 = m[2][j];
+        m[0][j] = c * r0 - s * r2;
+        m[2][j] = s * r0 + c * r2;
+    }
 }
 
 void Matrix::SetScale(float x, float y, float z) {
@@ -193,10 +339,13 @@ void Matrix::SetScale(float x, float y, float z) {
     m[2][2] = z;
 }
 
+//Left-multiplying by a scale matrix only scales the first three rows
 void Matrix::Scale(float x, float y, float z) {
-    Matrix scaleMatrix;
-    scaleMatrix.SetScale(x, y, z);
-    (*this) = scaleMatrix * (*this);
+    for (int j = 0; j < 4; j++) {
+        m[0][j] *= x;
+        m[1][j] *= y;
+        m[2][j] *= z;
+    }
 }
 
 void Matrix::SetOrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar) {
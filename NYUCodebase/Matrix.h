@@ -1,10 +1,19 @@
 
 #pragma once
 
-class Matrix {
+//SSE2 paths for multiply, inverse and vector transforms; everything else
+//(and non-x86 targets, or builds defining MATRIX_NO_SIMD) uses the scalar code
+#if !defined(MATRIX_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+    #define MATRIX_SSE
+#endif
+
+class alignas(16) Matrix {
     public:
     
-        Matrix();
+        constexpr Matrix() : m{ { 1.0f, 0.0f, 0.0f, 0.0f },
+                                { 0.0f, 1.0f, 0.0f, 0.0f },
+                                { 0.0f, 0.0f, 1.0f, 0.0f },
+                                { 0.0f, 0.0f, 0.0f, 1.0f } } {}
     
         union {
             float m[4][4];
@@ -15,6 +24,13 @@ class Matrix {
         Matrix operator * (const Matrix &m2) const;
         Matrix Inverse() const;
     
+        //Reference implementations the SIMD versions are checked against
+        Matrix MultiplyScalar(const Matrix &m2) const;
+        Matrix InverseScalar() const;
+    
+        //out = this * in, treating in as a column vector the way the shaders do
+        void TransformVector(const float in[4], float out[4]) const;
+    
         void Translate(float x, float y, float z);
         void Scale(float x, float y, float z);
         void Rotate(float rotation);
@@ -31,4 +47,25 @@ class Matrix {
 
         void SetOrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar);
         void SetPerspectiveProjection(float fov, float aspect, float zNear, float zFar);
+    
+        //Compile-time friendly builders, these only touch m (never ml) so they
+        //work in constant expressions
+        static constexpr Matrix Translation(float x, float y, float z) {
+            Matrix r;
+            r.m[3][0] = x;
+            r.m[3][1] = y;
+            r.m[3][2] = z;
+            return r;
+        }
+    
+        static constexpr Matrix OrthoProjection(float left, float right, float bottom, float top, float zNear, float zFar) {
+            Matrix r;
+            r.m[0][0] = 2.0f/(right-left);
+            r.m[1][1] = 2.0f/(top-bottom);
+            r.m[2][2] = -2.0f/(zFar-zNear);
+            r.m[3][0] = -((right+left)/(right-left));
+            r.m[3][1] = -((top+bottom)/(top-bottom));
+            r.m[3][2] = -((zFar+zNear)/(zFar-zNear));
+            return r;
+        }
 };
@@ -0,0 +1,50 @@
+#include "PerfStats.h"
+#include <algorithm>
+
+PerfCounters perf_counters;
+PerfHistory perf_history;
+
+void RollingHistogram::add(float sample) {
+	samples[next] = sample;
+	next = (next + 1) % PERF_HISTORY_SIZE;
+	if (count < PERF_HISTORY_SIZE) {
+		count++;
+	}
+}
+
+float RollingHistogram::sum() const {
+	float total = 0;
+	for (int i = 0; i < count; i++) {
+		total += samples[i];
+	}
+	return total;
+}
+
+float RollingHistogram::average() const {
+	if (count == 0) {
+		return 0;
+	}
+	return sum() / count;
+}
+
+float RollingHistogram::percentile(float fraction) const {
+	if (count == 0) {
+		return 0;
+	}
+
+	float sorted[PERF_HISTORY_SIZE];
+	std::copy(samples, samples + count, sorted);
+	int index = std::min(count - 1, (int)(fraction * count));
+	std::nth_element(sorted, sorted + index, sorted + count);
+	return sorted[index];
+}
+
+
+void perf_end_frame(float frame_seconds) {
+	perf_history.frame_ms.add(frame_seconds * 1000.0f);
+	perf_history.draw_calls.add(perf_counters.draw_calls);
+	perf_history.state_changes.add(perf_counters.state_changes);
+	perf_history.uploads.add(perf_counters.uploads);
+	perf_history.last_frame = perf_counters;
+	perf_counters = PerfCounters();
+}
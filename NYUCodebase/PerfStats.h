@@ -0,0 +1,60 @@
+#pragma once
+
+//Per-frame counters and rolling frame histograms for the performance overlay
+
+struct PerfCounters {
+	unsigned int draw_calls = 0;
+	unsigned int state_changes = 0; //GL calls wrapped in GL_STATE, see below
+	unsigned int uploads = 0; //buffer and texture data calls wrapped in GL_UPLOAD
+	unsigned int culled = 0; //entities skipped by viewport culling
+};
+
+//Counters of the frame in progress, bumped by the render and update code
+extern PerfCounters perf_counters;
+
+inline void count_draw_call() { perf_counters.draw_calls++; }
+inline void count_state_change() { perf_counters.state_changes++; }
+inline void count_upload() { perf_counters.uploads++; }
+inline void count_culled() { perf_counters.culled++; }
+
+//Issue a GL call and count it, so the counts can't drift from the calls. GL_STATE is for
+//binds and settings (programs, textures and their parameters, uniforms, buffers,
+//framebuffers, pixel store), GL_UPLOAD for calls that send buffer or texture data.
+//
+//	GL_STATE(glBindTexture(GL_TEXTURE_2D, texture));
+//	GL_UPLOAD(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels));
+#define GL_STATE(call) do { call; count_state_change(); } while (0)
+#define GL_UPLOAD(call) do { call; count_upload(); } while (0)
+
+
+//Fixed window of the most recent samples
+#define PERF_HISTORY_SIZE 240
+
+class RollingHistogram {
+public:
+	void add(float sample);
+
+	float average() const;
+	float percentile(float fraction) const;
+	float sum() const;
+	int size() const { return count; }
+
+private:
+	float samples[PERF_HISTORY_SIZE];
+	int count = 0;
+	int next = 0;
+};
+
+
+struct PerfHistory {
+	RollingHistogram frame_ms;
+	RollingHistogram draw_calls;
+	RollingHistogram state_changes;
+	RollingHistogram uploads;
+	PerfCounters last_frame;
+};
+
+extern PerfHistory perf_history;
+
+//Call at the end of each frame with its duration, then counters restart
+void perf_end_frame(float frame_seconds);
@@ -0,0 +1,98 @@
+#include "Profiler.h"
+
+#ifdef PROFILING
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#define PROFILE_RING_SIZE (1 << 16)
+
+struct ProfileEvent {
+	const char* name;
+	int64_t start;
+	int64_t end;
+};
+
+struct ProfileThreadBuffer {
+	int thread_id;
+	//Only the owning thread writes, the exporter reads up to `written`
+	std::atomic<uint64_t> written;
+	ProfileEvent events[PROFILE_RING_SIZE];
+};
+
+static std::mutex registry_mutex;
+static std::vector<ProfileThreadBuffer*> thread_buffers;
+static thread_local ProfileThreadBuffer* this_thread_buffer = NULL;
+
+static const std::chrono::steady_clock::time_point profile_epoch = std::chrono::steady_clock::now();
+
+//Nanoseconds since startup
+static int64_t profile_now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profile_epoch).count();
+}
+
+static ProfileThreadBuffer* thread_buffer() {
+	if (this_thread_buffer == NULL) {
+		ProfileThreadBuffer* buffer = new ProfileThreadBuffer();
+		buffer->written = 0;
+
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		buffer->thread_id = (int)thread_buffers.size();
+		thread_buffers.push_back(buffer);
+		this_thread_buffer = buffer;
+	}
+	return this_thread_buffer;
+}
+
+
+ProfileZone::ProfileZone(const char* name_) {
+	name = name_;
+	start = profile_now();
+}
+
+ProfileZone::~ProfileZone() {
+	int64_t end = profile_now();
+	ProfileThreadBuffer* buffer = thread_buffer();
+
+	uint64_t index = buffer->written.load(std::memory_order_relaxed);
+	ProfileEvent& event = buffer->events[index % PROFILE_RING_SIZE];
+	event.name = name;
+	event.start = start;
+	event.end = end;
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+
+bool profiler_write_chrome_trace(const char* path) {
+	FILE* file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	for (size_t t = 0; t < thread_buffers.size(); t++) {
+		ProfileThreadBuffer* buffer = thread_buffers[t];
+		uint64_t written = buffer->written.load(std::memory_order_acquire);
+		uint64_t oldest = written > PROFILE_RING_SIZE ? written - PROFILE_RING_SIZE : 0;
+
+		for (uint64_t i = oldest; i < written; i++) {
+			const ProfileEvent& event = buffer->events[i % PROFILE_RING_SIZE];
+			//trace_event wants microseconds
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				first ? "" : ",\n", event.name, buffer->thread_id, event.start / 1000.0, (event.end - event.start) / 1000.0);
+			first = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+//Scoped-zone frame profiler. Define PROFILING in the project to turn it on,
+//otherwise PROFILE_ZONE compiles to nothing.
+//
+//	void update(){
+//		PROFILE_ZONE("GameLevel::update");
+//		...
+//	}
+//
+//Each thread records into its own ring buffer with no locking; only the first
+//zone on a new thread takes a lock to register the buffer. Once the ring is
+//full the oldest zones are overwritten.
+
+#ifdef PROFILING
+
+#include <stdint.h>
+
+class ProfileZone {
+public:
+	ProfileZone(const char* name_);
+	~ProfileZone();
+private:
+	const char* name;
+	int64_t start;
+};
+
+#define PROFILE_ZONE_CONCAT2(a, b) a##b
+#define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_ZONE_CONCAT(profile_zone_, __LINE__)(name)
+
+//Writes every recorded zone of every thread in Chrome trace_event format
+//(load it in chrome://tracing or ui.perfetto.dev)
+bool profiler_write_chrome_trace(const char* path);
+
+#else
+
+#define PROFILE_ZONE(name)
+
+inline bool profiler_write_chrome_trace(const char*) { return false; }
+
+#endif
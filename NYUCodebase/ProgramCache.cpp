@@ -0,0 +1,142 @@
+#include "ProgramCache.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+	#include <direct.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+static const char* cache_directory = "shader_cache";
+static const uint32_t cache_magic = 0x31424750; //"PGB1"
+
+struct ProgramCacheHeader {
+	uint32_t magic;
+	uint32_t format; //GLenum from glGetProgramBinary
+	uint64_t source_hash;
+	uint64_t driver_hash;
+	uint32_t length;
+	uint32_t padding;
+};
+
+//64-bit FNV-1a, chained through hash so several strings make one key
+static uint64_t fnv1a(const char* data, size_t length, uint64_t hash = 14695981039346656037ull) {
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint64_t fnv1a(const std::string& text, uint64_t hash = 14695981039346656037ull) {
+	//Include the length so ("ab", "c") and ("a", "bc") differ
+	uint64_t length = text.size();
+	hash = fnv1a((const char*)&length, sizeof(length), hash);
+	return fnv1a(text.data(), text.size(), hash);
+}
+
+static std::string base_name(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+ProgramCacheEntry program_cache_entry(const std::string& vertexFile, const std::string& fragmentFile,
+	const std::string& vertexSource, const std::string& fragmentSource) {
+	ProgramCacheEntry entry;
+	entry.source_hash = 0;
+	entry.driver_hash = 0;
+
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (formats <= 0) {
+		return entry;
+	}
+
+	entry.source_hash = fnv1a(fragmentSource, fnv1a(vertexSource));
+	GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	entry.driver_hash = 14695981039346656037ull;
+	for (GLenum name : driver_strings) {
+		const char* text = (const char*)glGetString(name);
+		entry.driver_hash = fnv1a(std::string(text != NULL ? text : ""), entry.driver_hash);
+	}
+
+	entry.path = std::string(cache_directory) + "/" + base_name(vertexFile) + "+" + base_name(fragmentFile) + ".bin";
+	return entry;
+}
+
+bool program_cache_load(GLuint program, const ProgramCacheEntry& entry) {
+	if (!entry.enabled()) {
+		return false;
+	}
+
+	FILE* file = fopen(entry.path.c_str(), "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	ProgramCacheHeader header;
+	std::vector<char> binary;
+	bool read = fread(&header, sizeof(header), 1, file) == 1 &&
+		header.magic == cache_magic &&
+		header.source_hash == entry.source_hash &&
+		header.driver_hash == entry.driver_hash &&
+		header.length > 0;
+	if (read) {
+		binary.resize(header.length);
+		read = fread(&binary[0], 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+	if (!read) {
+		return false;
+	}
+
+	//Drivers may still reject a binary they produced, e.g. after an update that kept the version string
+	glProgramBinary(program, header.format, &binary[0], (GLsizei)binary.size());
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	return linked != GL_FALSE;
+}
+
+bool program_cache_save(GLuint program, const ProgramCacheEntry& entry) {
+	if (!entry.enabled()) {
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return false;
+	}
+
+	ProgramCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	std::vector<char> binary(length);
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &written, &format, &binary[0]);
+	if (written <= 0) {
+		return false;
+	}
+	header.magic = cache_magic;
+	header.format = format;
+	header.source_hash = entry.source_hash;
+	header.driver_hash = entry.driver_hash;
+	header.length = (uint32_t)written;
+
+#ifdef _WIN32
+	_mkdir(cache_directory);
+#else
+	mkdir(cache_directory, 0755);
+#endif
+
+	FILE* file = fopen(entry.path.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool saved = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&binary[0], 1, written, file) == (size_t)written;
+	fclose(file);
+	return saved;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <string>
+
+//On-disk cache of linked shader programs (glGetProgramBinary / glProgramBinary).
+//
+//Each program gets one file in shader_cache/ named after its shader files. The file
+//records a hash of both sources and of the GL vendor, renderer and version strings,
+//so editing a shader or updating the driver makes the entry miss, the program is
+//compiled from source as usual and the entry is rewritten.
+//
+//	ProgramCacheEntry entry = program_cache_entry(vertexFile, fragmentFile, vertexSource, fragmentSource);
+//	if (!program_cache_load(programID, entry)) {
+//		...compile, glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE), link...
+//		program_cache_save(programID, entry);
+//	}
+//
+//When the driver offers no binary formats the entry has an empty path, enabled() is
+//false and load and save do nothing.
+
+struct ProgramCacheEntry {
+	std::string path;
+	unsigned long long source_hash;
+	unsigned long long driver_hash;
+
+	bool enabled() const { return !path.empty(); }
+};
+
+ProgramCacheEntry program_cache_entry(const std::string& vertexFile, const std::string& fragmentFile,
+	const std::string& vertexSource, const std::string& fragmentSource);
+
+//Loads the cached binary into program, true if it was found, matched and linked
+bool program_cache_load(GLuint program, const ProgramCacheEntry& entry);
+//Stores program's binary, program must be linked with the retrievable hint set
+bool program_cache_save(GLuint program, const ProgramCacheEntry& entry);
@@ -0,0 +1,59 @@
+#include "RenderTarget.h"
+#include <string.h>
+
+RenderTarget::RenderTarget(int width_, int height_) : width(width_), height(height_) {
+	glGenRenderbuffers(1, &color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &color_buffer);
+		framebuffer = 0;
+		color_buffer = 0;
+	}
+}
+
+RenderTarget::~RenderTarget() {
+	if (framebuffer) {
+		glDeleteFramebuffers(1, &framebuffer);
+	}
+	if (color_buffer) {
+		glDeleteRenderbuffers(1, &color_buffer);
+	}
+}
+
+void RenderTarget::bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void RenderTarget::unbind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void RenderTarget::read(std::vector<unsigned char>* rgb) const {
+	size_t row_size = (size_t)width * 3;
+	rgb->resize(row_size * height);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &(*rgb)[0]);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+	//GL rows start at the bottom
+	std::vector<unsigned char> row(row_size);
+	for (int y = 0; y < height / 2; y++) {
+		unsigned char* top = &(*rgb)[y * row_size];
+		unsigned char* bottom = &(*rgb)[(height - 1 - y) * row_size];
+		memcpy(&row[0], top, row_size);
+		memcpy(top, bottom, row_size);
+		memcpy(bottom, &row[0], row_size);
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <vector>
+
+//Offscreen color buffer a whole frame can be drawn into and read back to memory,
+//for --render-test where nothing is presented.
+//
+//	target.bind();
+//	render_game();
+//	target.unbind();
+//	target.read(&rgb);
+class RenderTarget {
+public:
+	RenderTarget(int width_, int height_);
+	~RenderTarget();
+
+	//False if the driver can't make the framebuffer
+	bool valid() const { return framebuffer != 0; }
+	int get_width() const { return width; }
+	int get_height() const { return height; }
+
+	void bind();
+	void unbind();
+	//3 bytes per pixel, top row first like image files
+	void read(std::vector<unsigned char>* rgb) const;
+
+private:
+	RenderTarget(const RenderTarget&);
+	RenderTarget& operator=(const RenderTarget&);
+
+	int width;
+	int height;
+	GLuint framebuffer = 0;
+	GLuint color_buffer = 0;
+};
@@ -1,28 +1,108 @@
 
 #include "ShaderProgram.h"
+#include "PerfStats.h"
+#include "ProgramCache.h"
 
 void ShaderProgram::Load(const char *vertexShaderFile, const char *fragmentShaderFile) {
+    this->vertexShaderFile = vertexShaderFile;
+    this->fragmentShaderFile = fragmentShaderFile;
+    std::string vertexSource = ReadShaderFile(vertexShaderFile);
+    std::string fragmentSource = ReadShaderFile(fragmentShaderFile);
+    
+    programID = glCreateProgram();
+    vertexShader = 0;
+    fragmentShader = 0;
+    
+    // A cached binary from an earlier run skips compiling and linking entirely
+    ProgramCacheEntry cacheEntry = program_cache_entry(vertexShaderFile, fragmentShaderFile, vertexSource, fragmentSource);
+    if(program_cache_load(programID, cacheEntry)) {
+        FindLocations();
+        return;
+    }
     
     // create the vertex shader
-    vertexShader = LoadShaderFromFile(vertexShaderFile, GL_VERTEX_SHADER);
+    vertexShader = LoadShaderFromString(vertexSource, GL_VERTEX_SHADER);
     // create the fragment shader
-    fragmentShader = LoadShaderFromFile(fragmentShaderFile, GL_FRAGMENT_SHADER);
+    fragmentShader = LoadShaderFromString(fragmentSource, GL_FRAGMENT_SHADER);
     
     // Create the final shader program from our vertex and fragment shaders
-    programID = glCreateProgram();
     glAttachShader(programID, vertexShader);
     glAttachShader(programID, fragmentShader);
+    if(cacheEntry.enabled()) {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if(Link()) {
+        program_cache_save(programID, cacheEntry);
+    }
+}
+
+bool ShaderProgram::Reload() {
+    std::string vertexSource = ReadShaderFile(vertexShaderFile);
+    std::string fragmentSource = ReadShaderFile(fragmentShaderFile);
+    GLuint newVertexShader = LoadShaderFromString(vertexSource, GL_VERTEX_SHADER);
+    GLuint newFragmentShader = LoadShaderFromString(fragmentSource, GL_FRAGMENT_SHADER);
+    
+    // Link a throwaway program first, so a broken edit never touches the one in use
+    GLuint trialProgram = glCreateProgram();
+    glAttachShader(trialProgram, newVertexShader);
+    glAttachShader(trialProgram, newFragmentShader);
+    glLinkProgram(trialProgram);
+    GLint linkSuccess = GL_FALSE;
+    glGetProgramiv(trialProgram, GL_LINK_STATUS, &linkSuccess);
+    glDeleteProgram(trialProgram);
+    if(linkSuccess == GL_FALSE) {
+        glDeleteShader(newVertexShader);
+        glDeleteShader(newFragmentShader);
+        std::cout << "Keeping the previous " << vertexShaderFile << " + " << fragmentShaderFile << std::endl;
+        return false;
+    }
+    
+    // Swap the shaders inside the existing program so programID stays the same for everyone holding it.
+    // A program loaded from the binary cache has no shaders attached.
+    if(vertexShader != 0) {
+        glDetachShader(programID, vertexShader);
+        glDeleteShader(vertexShader);
+    }
+    if(fragmentShader != 0) {
+        glDetachShader(programID, fragmentShader);
+        glDeleteShader(fragmentShader);
+    }
+    vertexShader = newVertexShader;
+    fragmentShader = newFragmentShader;
+    glAttachShader(programID, vertexShader);
+    glAttachShader(programID, fragmentShader);
+    
+    ProgramCacheEntry cacheEntry = program_cache_entry(vertexShaderFile, fragmentShaderFile, vertexSource, fragmentSource);
+    if(cacheEntry.enabled()) {
+        glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if(Link()) {
+        program_cache_save(programID, cacheEntry);
+    }
+    std::cout << "Reloaded " << vertexShaderFile << " + " << fragmentShaderFile << std::endl;
+    return true;
+}
+
+bool ShaderProgram::Link() {
     glLinkProgram(programID);
     
-    GLint linkSuccess;
+    GLint linkSuccess = GL_FALSE;
     glGetProgramiv(programID, GL_LINK_STATUS, &linkSuccess);
     if(linkSuccess == GL_FALSE) {
 	printf("Error linking shader program!\n");
     }
     
+    FindLocations();
+    return linkSuccess != GL_FALSE;
+}
+
+// Looks up uniforms and attributes, which a relink may move
+void ShaderProgram::FindLocations() {
     modelMatrixUniform = glGetUniformLocation(programID, "modelMatrix");
     projectionMatrixUniform = glGetUniformLocation(programID, "projectionMatrix");
     viewMatrixUniform = glGetUniformLocation(programID, "viewMatrix");
+    transformUniform = glGetUniformLocation(programID, "transform");
+    translationUniform = glGetUniformLocation(programID, "translation");
 	colorUniform = glGetUniformLocation(programID, "color");
     
     positionAttribute = glGetAttribLocation(programID, "position");
@@ -30,6 +110,24 @@ void ShaderProgram::Load(const char *vertexShaderFile, const char *fragmentShade
 	
 	SetColor(1.0f, 1.0f, 1.0f, 1.0f);
     
+    for(size_t i = 0; i < uniformBlocks.size(); i++) {
+        GLuint blockIndex = glGetUniformBlockIndex(programID, uniformBlocks[i].name.c_str());
+        if(blockIndex != GL_INVALID_INDEX) {
+            glUniformBlockBinding(programID, blockIndex, uniformBlocks[i].binding);
+        }
+    }
+}
+
+bool ShaderProgram::BindUniformBlock(const char *blockName, GLuint binding) {
+    GLuint blockIndex = glGetUniformBlockIndex(programID, blockName);
+    if(blockIndex == GL_INVALID_INDEX) {
+        return false;
+    }
+    
+    glUniformBlockBinding(programID, blockIndex, binding);
+    UniformBlockBinding block = { blockName, binding };
+    uniformBlocks.push_back(block);
+    return true;
 }
 
 void ShaderProgram::Cleanup() {
@@ -39,6 +137,11 @@ void ShaderProgram::Cleanup() {
 }
 
 GLuint ShaderProgram::LoadShaderFromFile(const std::string &shaderFile, GLenum type) {
+    // Load the shader from the contents of the file
+    return LoadShaderFromString(ReadShaderFile(shaderFile), type);
+}
+
+std::string ShaderProgram::ReadShaderFile(const std::string &shaderFile) {
     //Open a file stream with the file name
     std::ifstream infile(shaderFile);
     
@@ -50,8 +153,7 @@ GLuint ShaderProgram::LoadShaderFromFile(const std::string &shaderFile, GLenum t
     std::stringstream buffer;
     buffer << infile.rdbuf();
     
-    // Load the shader from the contents of the file
-    return LoadShaderFromString(buffer.str(), type);
+    return buffer.str();
 }
 
 GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GLenum type) {
@@ -84,21 +186,27 @@ GLuint ShaderProgram::LoadShaderFromString(const std::string &shaderContents, GL
 }
 
 void ShaderProgram::SetColor(float r, float g, float b, float a) {
-	glUseProgram(programID);
-	glUniform4f(colorUniform, r, g, b, a);
+	GL_STATE(glUseProgram(programID));
+	GL_STATE(glUniform4f(colorUniform, r, g, b, a));
 }
 
 void ShaderProgram::SetViewMatrix(const Matrix &matrix) {
-    glUseProgram(programID);
-    glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, matrix.ml);
+    GL_STATE(glUseProgram(programID));
+    GL_STATE(glUniformMatrix4fv(viewMatrixUniform, 1, GL_FALSE, matrix.ml));
 }
 
 void ShaderProgram::SetModelMatrix(const Matrix &matrix) {
-    glUseProgram(programID);
-    glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, matrix.ml);
+    GL_STATE(glUseProgram(programID));
+    GL_STATE(glUniformMatrix4fv(modelMatrixUniform, 1, GL_FALSE, matrix.ml));
+}
+
+void ShaderProgram::SetTransform2D(const Affine2D &transform) {
+    GL_STATE(glUseProgram(programID));
+    GL_STATE(glUniform4f(transformUniform, transform.a, transform.b, transform.c, transform.d));
+    GL_STATE(glUniform2f(translationUniform, transform.tx, transform.ty));
 }
 
 void ShaderProgram::SetProjectionMatrix(const Matrix &matrix) {
-    glUseProgram(programID);
-    glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, matrix.ml);    
+    GL_STATE(glUseProgram(programID));
+    GL_STATE(glUniformMatrix4fv(projectionMatrixUniform, 1, GL_FALSE, matrix.ml));
 }
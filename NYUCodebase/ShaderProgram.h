@@ -8,27 +8,40 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include "Matrix.h"
+#include "Affine2D.h"
 
 class ShaderProgram {
     public:
 	void Load(const char *vertexShaderFile, const char *fragmentShaderFile);
+	//Recompiles the files given to Load and relinks into the same programID.
+	//If either shader or the link fails, the previous program stays in use.
+	bool Reload();
 	void Cleanup();   
 
         void SetModelMatrix(const Matrix &matrix);
         void SetProjectionMatrix(const Matrix &matrix);
         void SetViewMatrix(const Matrix &matrix);
+        //For the *_2d vertex shaders: 6 floats instead of a full model matrix
+        void SetTransform2D(const Affine2D &transform);
+        //Points the named uniform block at a uniform buffer binding point, kept across relinks.
+        //False if the program has no such block.
+        bool BindUniformBlock(const char *blockName, GLuint binding);
 	
 		void SetColor(float r, float g, float b, float a);
 	
         GLuint LoadShaderFromString(const std::string &shaderContents, GLenum type);
         GLuint LoadShaderFromFile(const std::string &shaderFile, GLenum type);
+        static std::string ReadShaderFile(const std::string &shaderFile);
     
         GLuint programID;
     
         GLuint projectionMatrixUniform;
         GLuint modelMatrixUniform;
         GLuint viewMatrixUniform;
+        GLuint transformUniform;
+        GLuint translationUniform;
 		GLuint colorUniform;
 	
         GLuint positionAttribute;
@@ -36,4 +49,17 @@ class ShaderProgram {
     
         GLuint vertexShader;
         GLuint fragmentShader;
+
+        std::string vertexShaderFile;
+        std::string fragmentShaderFile;
+
+        struct UniformBlockBinding {
+            std::string name;
+            GLuint binding;
+        };
+        std::vector<UniformBlockBinding> uniformBlocks;
+
+    private:
+        bool Link();
+        void FindLocations();
 };
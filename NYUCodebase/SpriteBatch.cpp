@@ -0,0 +1,181 @@
+#include "SpriteBatch.h"
+#include "PerfStats.h"
+#include <string.h>
+#ifdef MATRIX_SSE
+	#include <emmintrin.h>
+#endif
+
+//Writes the 6 vertices of one quad given its corners packed as
+//a = (bl.x bl.y tr.x tr.y) and b = (tl.x tl.y br.x br.y)
+#ifdef MATRIX_SSE
+static inline void store_quad(float* out, __m128 a, __m128 b) {
+	_mm_storeu_ps(out, a);
+	_mm_storeu_ps(out + 4, _mm_shuffle_ps(b, a, _MM_SHUFFLE(3, 2, 1, 0)));
+	_mm_storeu_ps(out + 8, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 1, 0)));
+}
+#endif
+
+void transform_quads(const Matrix& transform, const float* xs, const float* ys,
+	const float* half_widths, const float* half_heights, int count, float* out_positions) {
+	float m00 = transform.m[0][0], m01 = transform.m[0][1];
+	float m10 = transform.m[1][0], m11 = transform.m[1][1];
+	float m30 = transform.m[3][0], m31 = transform.m[3][1];
+
+	int i = 0;
+#ifdef MATRIX_SSE
+	__m128 a00 = _mm_set1_ps(m00), a01 = _mm_set1_ps(m01);
+	__m128 a10 = _mm_set1_ps(m10), a11 = _mm_set1_ps(m11);
+	__m128 a30 = _mm_set1_ps(m30), a31 = _mm_set1_ps(m31);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(xs + i);
+		__m128 y = _mm_loadu_ps(ys + i);
+		__m128 hw = _mm_loadu_ps(half_widths + i);
+		__m128 hh = _mm_loadu_ps(half_heights + i);
+
+		__m128 left = _mm_sub_ps(x, hw);
+		__m128 right = _mm_add_ps(x, hw);
+		__m128 bottom = _mm_sub_ps(y, hh);
+		__m128 top = _mm_add_ps(y, hh);
+
+		//x' = m00*x + m10*y + m30, y' = m01*x + m11*y + m31 for each corner of 4 quads
+		__m128 left_x = _mm_mul_ps(a00, left), left_y = _mm_mul_ps(a01, left);
+		__m128 right_x = _mm_mul_ps(a00, right), right_y = _mm_mul_ps(a01, right);
+		__m128 bottom_x = _mm_add_ps(_mm_mul_ps(a10, bottom), a30), bottom_y = _mm_add_ps(_mm_mul_ps(a11, bottom), a31);
+		__m128 top_x = _mm_add_ps(_mm_mul_ps(a10, top), a30), top_y = _mm_add_ps(_mm_mul_ps(a11, top), a31);
+
+		__m128 bl_x = _mm_add_ps(left_x, bottom_x), bl_y = _mm_add_ps(left_y, bottom_y);
+		__m128 tr_x = _mm_add_ps(right_x, top_x), tr_y = _mm_add_ps(right_y, top_y);
+		__m128 tl_x = _mm_add_ps(left_x, top_x), tl_y = _mm_add_ps(left_y, top_y);
+		__m128 br_x = _mm_add_ps(right_x, bottom_x), br_y = _mm_add_ps(right_y, bottom_y);
+
+		//Transpose from one corner component per register to one quad per register
+		_MM_TRANSPOSE4_PS(bl_x, bl_y, tr_x, tr_y);
+		_MM_TRANSPOSE4_PS(tl_x, tl_y, br_x, br_y);
+
+		store_quad(out_positions + (i + 0) * 12, bl_x, tl_x);
+		store_quad(out_positions + (i + 1) * 12, bl_y, tl_y);
+		store_quad(out_positions + (i + 2) * 12, tr_x, br_x);
+		store_quad(out_positions + (i + 3) * 12, tr_y, br_y);
+	}
+#endif
+
+	for (; i < count; i++) {
+		float left = xs[i] - half_widths[i];
+		float right = xs[i] + half_widths[i];
+		float bottom = ys[i] - half_heights[i];
+		float top = ys[i] + half_heights[i];
+
+		float corners[8] = {
+			m00 * left + m10 * bottom + m30, m01 * left + m11 * bottom + m31, //bottom left
+			m00 * right + m10 * top + m30, m01 * right + m11 * top + m31, //top right
+			m00 * left + m10 * top + m30, m01 * left + m11 * top + m31, //top left
+			m00 * right + m10 * bottom + m30, m01 * right + m11 * bottom + m31 //bottom right
+		};
+
+		float* out = out_positions + i * 12;
+		memcpy(out, corners, 4 * sizeof(float));
+		memcpy(out + 4, corners + 4, 2 * sizeof(float));
+		memcpy(out + 6, corners + 2, 2 * sizeof(float));
+		memcpy(out + 8, corners, 2 * sizeof(float));
+		memcpy(out + 10, corners + 6, 2 * sizeof(float));
+	}
+}
+
+
+//Same vertex order as transform_quads: bl tr tl tr bl br
+static void write_quad_uvs(const float* rect, float* out) {
+	float u0 = rect[0], v0 = rect[1], u1 = rect[2], v1 = rect[3];
+	float uvs[12] = {
+		u0, v1,
+		u1, v0,
+		u0, v0,
+		u1, v0,
+		u0, v1,
+		u1, v1
+	};
+	memcpy(out, uvs, sizeof(uvs));
+}
+
+
+SpriteBatch::SpriteBatch(int initial_capacity) {
+	xs.reserve(initial_capacity);
+	ys.reserve(initial_capacity);
+	half_widths.reserve(initial_capacity);
+	half_heights.reserve(initial_capacity);
+	uv_rects.reserve(initial_capacity * 4);
+	glGenBuffers(1, &vbo);
+}
+
+SpriteBatch::~SpriteBatch() {
+	glDeleteBuffers(1, &vbo);
+}
+
+void SpriteBatch::begin(ShaderProgram* program_, const Matrix& transform_) {
+	program = program_;
+	transform = transform_;
+}
+
+void SpriteBatch::add(GLuint texture_, float x, float y, float half_width, float half_height, float u0, float v0, float u1, float v1) {
+	if (texture_ != texture && size() > 0) {
+		flush();
+	}
+	texture = texture_;
+
+	xs.push_back(x);
+	ys.push_back(y);
+	half_widths.push_back(half_width);
+	half_heights.push_back(half_height);
+	float rect[4] = { u0, v0, u1, v1 };
+	uv_rects.insert(uv_rects.end(), rect, rect + 4);
+}
+
+void SpriteBatch::end() {
+	if (size() > 0) {
+		flush();
+	}
+}
+
+void SpriteBatch::flush() {
+	int count = size();
+	size_t positions_size = count * 12 * sizeof(float);
+
+	//Orphan last frame's storage so mapping never waits on the GPU
+	GL_STATE(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+	GL_UPLOAD(glBufferData(GL_ARRAY_BUFFER, positions_size * 2, NULL, GL_STREAM_DRAW));
+	float* mapped = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+	if (mapped != NULL) {
+		transform_quads(transform, xs.data(), ys.data(), half_widths.data(), half_heights.data(), count, mapped);
+		float* uvs = mapped + count * 12;
+		for (int i = 0; i < count; i++) {
+			write_quad_uvs(&uv_rects[i * 4], uvs + i * 12);
+		}
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		program->SetTransform2D(Affine2D());
+		GL_STATE(glUseProgram(program->programID));
+		GL_STATE(glBindTexture(GL_TEXTURE_2D, texture));
+		GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+		//Draws sprites pixel perfect with no blur
+		GL_STATE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+
+		glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, (void*)0);
+		glEnableVertexAttribArray(program->positionAttribute);
+		glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, (void*)positions_size);
+		glEnableVertexAttribArray(program->texCoordAttribute);
+
+		glDrawArrays(GL_TRIANGLES, 0, count * 6);
+		count_draw_call();
+
+		glDisableVertexAttribArray(program->positionAttribute);
+		glDisableVertexAttribArray(program->texCoordAttribute);
+	}
+	GL_STATE(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+	xs.clear();
+	ys.clear();
+	half_widths.clear();
+	half_heights.clear();
+	uv_rects.clear();
+}
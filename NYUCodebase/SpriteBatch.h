@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+#include <vector>
+#include "Matrix.h"
+#include "ShaderProgram.h"
+
+//Transforms `count` axis-aligned quads (center + half extents) by the x/y part of
+//`transform` and writes 6 vertices (12 floats) per quad to out_positions, two
+//triangles in the order bottom-left, top-right, top-left, top-right, bottom-left, bottom-right
+void transform_quads(const Matrix& transform, const float* xs, const float* ys,
+	const float* half_widths, const float* half_heights, int count, float* out_positions);
+
+
+//Collects textured quads and draws each run of same-texture quads with one
+//glDrawArrays from a streamed VBO. Vertices are pre-transformed on the CPU, so
+//the program's model transform is left at identity.
+//
+//	batch.begin(tex_program, viewMatrix);
+//	batch.add(texture, x, y, ...);
+//	batch.end();
+class SpriteBatch {
+public:
+	SpriteBatch(int initial_capacity);
+	~SpriteBatch();
+
+	void begin(ShaderProgram* program_, const Matrix& transform_);
+	//uv0 is the top-left texel corner, uv1 the bottom-right
+	void add(GLuint texture_, float x, float y, float half_width, float half_height, float u0, float v0, float u1, float v1);
+	void end();
+
+	int size() const { return (int)xs.size(); }
+
+private:
+	SpriteBatch(const SpriteBatch&);
+	SpriteBatch& operator=(const SpriteBatch&);
+
+	void flush();
+
+	ShaderProgram* program = NULL;
+	Matrix transform;
+	GLuint texture = 0;
+	GLuint vbo = 0;
+
+	//Staged quads, structure-of-arrays so transform_quads can load 4 at a time
+	std::vector<float> xs;
+	std::vector<float> ys;
+	std::vector<float> half_widths;
+	std::vector<float> half_heights;
+	std::vector<float> uv_rects; //u0 v0 u1 v1 per quad
+};
@@ -0,0 +1,56 @@
+#include "StaticLayer.h"
+#include "PerfStats.h"
+#include <iostream>
+
+StaticLayer::StaticLayer(int width_, int height_) : width(width_), height(height_) {
+	//Only blitted, never sampled, so a renderbuffer is enough
+	glGenRenderbuffers(1, &color_buffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_buffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		std::cout << "Static layer framebuffer incomplete (0x" << std::hex << status << std::dec << "), drawing the background every frame" << std::endl;
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &color_buffer);
+		framebuffer = 0;
+		color_buffer = 0;
+	}
+}
+
+StaticLayer::~StaticLayer() {
+	if (framebuffer) {
+		glDeleteFramebuffers(1, &framebuffer);
+	}
+	if (color_buffer) {
+		glDeleteRenderbuffers(1, &color_buffer);
+	}
+}
+
+void StaticLayer::begin() {
+	//Usually the window, but --render-test draws frames into its own framebuffer
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target_framebuffer);
+	GL_STATE(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void StaticLayer::end() {
+	GL_STATE(glBindFramebuffer(GL_FRAMEBUFFER, target_framebuffer));
+	is_valid = true;
+}
+
+void StaticLayer::present() const {
+	//Into whatever is bound for drawing, the window or a render test target
+	GLint target = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+	GL_STATE(glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer));
+	glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	GL_STATE(glBindFramebuffer(GL_READ_FRAMEBUFFER, target));
+	count_draw_call();
+}
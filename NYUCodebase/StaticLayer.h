@@ -0,0 +1,47 @@
+#pragma once
+
+#ifdef _WINDOWS
+	#include <GL/glew.h>
+#endif
+#include <SDL_opengl.h>
+
+//Offscreen copy of draws that rarely change (the background and intact barriers).
+//While the cache is valid, present() copies it over the whole back buffer, which
+//replaces both the clear and the redraw of everything in the layer.
+//
+//	if (!layer.valid()){
+//		layer.begin();
+//		...draw static things...
+//		layer.end();
+//	}
+//	layer.present();
+//
+//supported() is false when the framebuffer can't be created, callers then clear
+//and draw the static things every frame as before.
+class StaticLayer {
+public:
+	StaticLayer(int width_, int height_);
+	~StaticLayer();
+
+	bool supported() const { return framebuffer != 0; }
+	bool valid() const { return is_valid; }
+	void invalidate() { is_valid = false; }
+
+	//Redirects drawing into the layer and clears it
+	void begin();
+	//Restores the framebuffer bound before begin() and marks the layer valid
+	void end();
+	//Overwrites the back buffer with the layer, no blending and no clear needed
+	void present() const;
+
+private:
+	StaticLayer(const StaticLayer&);
+	StaticLayer& operator=(const StaticLayer&);
+
+	GLuint framebuffer = 0;
+	GLuint color_buffer = 0;
+	int width;
+	int height;
+	bool is_valid = false;
+	GLint target_framebuffer = 0; //bound before begin()
+};
@@ -0,0 +1,177 @@
+#include "Wave.h"
+#include <stdio.h>
+#include <string.h>
+
+bool wave_view(const unsigned char* data, size_t size, WaveView* view) {
+	if (size < sizeof(WaveHeader)) {
+		return false;
+	}
+
+	const WaveHeader* header = (const WaveHeader*)data;
+	if (header->magic != WAVE_MAGIC || header->version != WAVE_VERSION || header->size != size) {
+		return false;
+	}
+	if (header->row_count == 0 || header->row_count > WAVE_MAX_ROWS || header->columns == 0 || header->columns > 64) {
+		return false;
+	}
+	//Bounded before the sizes below are computed, so a huge count cannot wrap a 32-bit size_t
+	if (header->barrier_count > WAVE_MAX_BARRIERS) {
+		return false;
+	}
+
+	size_t rows_end = sizeof(WaveHeader) + header->row_count * sizeof(WaveRow);
+	size_t barriers_end = rows_end + (size_t)header->barrier_count * sizeof(WaveBarrier);
+	if (barriers_end != size) {
+		return false;
+	}
+
+	view->header = header;
+	view->rows = (const WaveRow*)(data + sizeof(WaveHeader));
+	view->barriers = (const WaveBarrier*)(data + rows_end);
+	return true;
+}
+
+
+bool WaveFile::load(const char* path) {
+	view = WaveView();
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long file_size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	bool read = file_size > 0 && (size_t)file_size <= sizeof(data) && fread(data, 1, file_size, file) == (size_t)file_size;
+	fclose(file);
+	size = read ? (size_t)file_size : 0;
+
+	if (!read || !wave_view(data, size, &view)) {
+		printf("%s is not a valid version %d wave file\n", path, WAVE_VERSION);
+		view = WaveView();
+		return false;
+	}
+	return true;
+}
+
+bool WaveFile::load_text(const char* text, const char* name) {
+	view = WaveView();
+
+	WaveHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = WAVE_MAGIC;
+	header.version = WAVE_VERSION;
+	std::vector<WaveRow> rows;
+	std::vector<WaveBarrier> barriers;
+
+	int line_number = 0;
+	const char* line = text;
+	while (*line != '\0') {
+		line_number++;
+		const char* line_end = strchr(line, '\n');
+		if (line_end == NULL) {
+			line_end = line + strlen(line);
+		}
+
+		char key[32] = "";
+		int key_length = 0;
+		sscanf(line, " %31s%n", key, &key_length);
+		const char* values = line + key_length;
+		bool parsed = true;
+
+		if (key[0] == '\0' || key[0] == '#' || key_length > line_end - line) {
+			//blank or comment
+		}
+		else if (strcmp(key, "columns") == 0) {
+			parsed = sscanf(values, "%u", &header.columns) == 1;
+		}
+		else if (strcmp(key, "origin") == 0) {
+			parsed = sscanf(values, "%f %f", &header.origin[0], &header.origin[1]) == 2;
+		}
+		else if (strcmp(key, "spacing") == 0) {
+			parsed = sscanf(values, "%f %f", &header.spacing[0], &header.spacing[1]) == 2;
+		}
+		else if (strcmp(key, "step_interval") == 0) {
+			parsed = sscanf(values, "%f", &header.step_interval) == 1;
+		}
+		else if (strcmp(key, "step_distance") == 0) {
+			parsed = sscanf(values, "%f", &header.step_distance) == 1;
+		}
+		else if (strcmp(key, "drop_distance") == 0) {
+			parsed = sscanf(values, "%f", &header.drop_distance) == 1;
+		}
+		else if (strcmp(key, "attack_interval") == 0) {
+			parsed = sscanf(values, "%f", &header.attack_interval) == 1;
+		}
+		else if (strcmp(key, "row") == 0) {
+			WaveRow row;
+			parsed = sscanf(values, "%u %u %u %u %f %u", &row.sheet_rect[0], &row.sheet_rect[1], &row.sheet_rect[2], &row.sheet_rect[3], &row.size, &row.points) == 6;
+			rows.push_back(row);
+		}
+		else if (strcmp(key, "barrier") == 0) {
+			WaveBarrier barrier;
+			parsed = sscanf(values, "%f %f %f", &barrier.position[0], &barrier.position[1], &barrier.size) == 3;
+			barriers.push_back(barrier);
+		}
+		else {
+			parsed = false;
+		}
+
+		if (!parsed) {
+			printf("%s:%d: can't parse \"%.*s\"\n", name, line_number, (int)(line_end - line), line);
+			return false;
+		}
+		line = *line_end == '\0' ? line_end : line_end + 1;
+	}
+
+	header.row_count = (uint32_t)rows.size();
+	header.barrier_count = (uint32_t)barriers.size();
+	if (rows.size() > WAVE_MAX_ROWS || barriers.size() > WAVE_MAX_BARRIERS) {
+		printf("%s: at most %d rows and %d barriers\n", name, WAVE_MAX_ROWS, WAVE_MAX_BARRIERS);
+		return false;
+	}
+	header.size = (uint32_t)(sizeof(WaveHeader) + rows.size() * sizeof(WaveRow) + barriers.size() * sizeof(WaveBarrier));
+
+	size = header.size;
+	memcpy(data, &header, sizeof(header));
+	if (!rows.empty()) {
+		memcpy(data + sizeof(header), &rows[0], rows.size() * sizeof(WaveRow));
+	}
+	if (!barriers.empty()) {
+		memcpy(data + sizeof(header) + rows.size() * sizeof(WaveRow), &barriers[0], barriers.size() * sizeof(WaveBarrier));
+	}
+
+	if (!wave_view(data, size, &view)) {
+		printf("%s: needs columns (1-64) and 1-%d rows\n", name, WAVE_MAX_ROWS);
+		view = WaveView();
+		return false;
+	}
+	return true;
+}
+
+bool WaveFile::save(const char* path) const {
+	if (!loaded()) {
+		return false;
+	}
+	FILE* file = fopen(path, "wb");
+	if (file == NULL) {
+		return false;
+	}
+	bool written = fwrite(data, 1, size, file) == size;
+	fclose(file);
+	return written;
+}
+
+bool read_text_file(const char* path, std::vector<char>* text) {
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	text->assign(size > 0 ? size + 1 : 1, '\0');
+	bool read = size <= 0 || fread(&(*text)[0], 1, size, file) == (size_t)size;
+	fclose(file);
+	return read;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//Wave files describe one enemy wave: the formation layout and pace, the look and
+//score of each enemy row, and where the barriers stand.
+//
+//resources/waves/*.txt is the source, one "key values..." per line and # comments.
+//`--compile-wave in.txt out.wave` turns it into the binary .wave the game loads:
+//
+//	WaveHeader, then row_count WaveRow, then barrier_count WaveBarrier
+//
+//All fields are 4 bytes and little-endian, so a loaded file is used in place through a
+//WaveView of pointers into its bytes, nothing is copied out field by field.
+
+#define WAVE_MAGIC 0x45564157 //"WAVE"
+#define WAVE_VERSION 1
+#define WAVE_MAX_ROWS 8
+#define WAVE_MAX_BARRIERS 8
+
+struct WaveHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size; //whole file in bytes
+	uint32_t columns;
+	uint32_t row_count;
+	uint32_t barrier_count;
+	float origin[2]; //center of the top-left enemy
+	float spacing[2]; //between columns, between rows
+	float step_interval; //seconds between row steps
+	float step_distance;
+	float drop_distance; //every 5 sweeps
+	float attack_interval; //seconds between enemy shots
+};
+
+//One formation row, top row first
+struct WaveRow {
+	uint32_t sheet_rect[4]; //x y width height in resources/sheet.png pixels
+	float size;
+	uint32_t points;
+};
+
+struct WaveBarrier {
+	float position[2];
+	float size;
+};
+
+//Pointers into a wave's bytes, valid while they are
+struct WaveView {
+	const WaveHeader* header = NULL;
+	const WaveRow* rows = NULL;
+	const WaveBarrier* barriers = NULL;
+};
+
+//Checks the magic, version and that every count fits inside size bytes
+bool wave_view(const unsigned char* data, size_t size, WaveView* view);
+
+
+//Largest valid file, WaveFile holds its bytes inline so loading never touches the heap
+#define WAVE_MAX_SIZE (sizeof(WaveHeader) + WAVE_MAX_ROWS * sizeof(WaveRow) + WAVE_MAX_BARRIERS * sizeof(WaveBarrier))
+
+class WaveFile {
+public:
+	WaveFile() {}
+	//Reads a binary .wave in one go and views it
+	bool load(const char* path);
+	//Compiles source text, for --compile-wave
+	bool load_text(const char* text, const char* name);
+	bool save(const char* path) const;
+
+	bool loaded() const { return view.header != NULL; }
+	const WaveView& get() const { return view; }
+
+private:
+	//view points into data, so a copy would point into the original
+	WaveFile(const WaveFile&);
+	WaveFile& operator=(const WaveFile&);
+
+	alignas(4) unsigned char data[WAVE_MAX_SIZE];
+	size_t size = 0;
+	WaveView view;
+};
+
+//Reads a whole text file, false if it can't be opened
+bool read_text_file(const char* path, std::vector<char>* text);
@@ -0,0 +1,11 @@
+#version 330 core
+// Core profile variant of fragment.glsl, also valid as "#version 300 es"
+precision mediump float;
+
+uniform vec4 color;
+
+out vec4 fragColor;
+
+void main() {
+	fragColor = color;
+}
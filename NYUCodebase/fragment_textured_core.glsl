@@ -0,0 +1,12 @@
+#version 330 core
+// Core profile variant of fragment_textured.glsl, also valid as "#version 300 es"
+precision mediump float;
+
+uniform sampler2D diffuse;
+in vec2 texCoordVar;
+
+out vec4 fragColor;
+
+void main() {
+	fragColor = texture(diffuse, texCoordVar);
+}
@@ -8,10 +8,32 @@
 #include "stb_image.h"
 
 #include "ShaderProgram.h"
+#include "Affine2D.h"
+#include "SpriteBatch.h"
+#include "StaticLayer.h"
+#include "CameraBuffer.h"
+#include "GLCore.h"
+#include "RenderTarget.h"
+#include "GoldenImage.h"
+#include "BarrierMask.h"
+#include "Formation.h"
+#include "Wave.h"
+#include "FrameArena.h"
+#include "AllocTracker.h"
+#include "Profiler.h"
+#include "PerfStats.h"
+#include "Benchmark.h"
+#include "FramePacer.h"
+#include "LatencyHarness.h"
+#include "FileWatcher.h"
+#include "ConstMath.h"
 #include <vector>
 #include <unordered_map>
 #include <math.h>
 #include <algorithm> //std::remove_if
+#include <type_traits> //std::is_trivially_copyable
+#include <stdint.h>
+#include <string.h> //memcpy, strlen
 #include <time.h>  
 #ifdef _WINDOWS
 	#define RESOURCE_FOLDER ""
@@ -22,14 +44,49 @@
 
 
 SDL_Window* displayWindow;
+const int window_width = 1000;
+const int window_height = 600;
 Matrix projectionMatrix;
 Matrix modelMatrix;
 Matrix viewMatrix;
 ShaderProgram* tex_program;
 ShaderProgram* shape_program;
+CameraBuffer* camera_buffer;
 GLuint font_texture;
 float elapsed;
 bool done = false;
+//Screen bounds never change, so the projection is baked at compile time
+constexpr float screen_left = -3.55f;
+constexpr float screen_right = 3.55f;
+constexpr float screen_top = 2.0f;
+constexpr float screen_bottom = -2.0f;
+constexpr Matrix screen_projection = Matrix::OrthoProjection(screen_left, screen_right, screen_bottom, screen_top, -1.0f, 1.0f);
+static_assert(screen_projection.m[1][1] == 0.5f, "screen_projection y scale");
+static_assert(screen_projection.m[0][0] == 2.0f / (screen_right - screen_left), "screen_projection x scale");
+static_assert(screen_projection.m[3][0] == 0.0f && screen_projection.m[3][1] == 0.0f, "screen_projection is centered");
+
+//World space rectangle seen through an orthographic projection
+struct ViewBounds {
+	float left;
+	float right;
+	float bottom;
+	float top;
+};
+
+//Maps clip space -1..1 back through the x and y rows of an ortho projection
+constexpr ViewBounds view_bounds_from_ortho(const Matrix& projection){
+	return ViewBounds{
+		(-1.0f - projection.m[3][0]) / projection.m[0][0],
+		(1.0f - projection.m[3][0]) / projection.m[0][0],
+		(-1.0f - projection.m[3][1]) / projection.m[1][1],
+		(1.0f - projection.m[3][1]) / projection.m[1][1]
+	};
+}
+
+constexpr ViewBounds playfield = { screen_left, screen_right, screen_bottom, screen_top };
+static_assert(view_bounds_from_ortho(screen_projection).top == screen_top, "view_bounds_from_ortho");
+static_assert(view_bounds_from_ortho(screen_projection).right > 3.549f && view_bounds_from_ortho(screen_projection).right < 3.551f, "view_bounds_from_ortho");
+
 float font_sheet_width = 0;
 float font_sheet_height = 0;
 
@@ -38,13 +95,42 @@ enum GameMode { STATE_MAIN_MENU, STATE_GAME_LEVEL, STATE_GAME_OVER, STATE_GAME_W
 GameMode mode;
 
 //seconds since program started
+//--render-test steps this by a fixed amount per frame so replays don't depend on wall time
+float replay_clock = -1.0f;
+//Held keys for --render-test, read instead of SDL_GetKeyboardState when set
+const Uint8* replay_keys = NULL;
+
 float get_runtime(){
+	if (replay_clock >= 0.0f){
+		return replay_clock;
+	}
 	float ticks = (float)SDL_GetTicks() / 1000.0f;
 	return ticks;
 }
 
 
-GLuint LoadTexture(const char* filePath, float* width, float* height){
+//--hot-reload: textures and shaders are re-read when their files change
+bool hot_reload = false;
+
+//Re-reads filePath into an existing texture, so every Sprite holding it sees the new pixels
+bool reload_texture(GLuint texture, const char* filePath){
+	int w, h, comp;
+	unsigned char* image = stbi_load(filePath, &w, &h, &comp, STBI_rgb_alpha);
+	if (image == NULL){
+		//Usually caught mid-save, the next write will trigger another reload
+		std::cout << "Unable to reload " << filePath << ", keeping the old image\n";
+		return false;
+	}
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+	stbi_image_free(image);
+	std::cout << "Reloaded " << filePath << "\n";
+	return true;
+}
+
+//rgba, when given, receives a CPU copy of the decoded RGBA8 image
+GLuint LoadTexture(const char* filePath, float* width, float* height, std::vector<unsigned char>* rgba = NULL){
 	int w, h, comp;
 	unsigned char* image = stbi_load(filePath, &w, &h, &comp, STBI_rgb_alpha);
 
@@ -63,6 +149,15 @@ GLuint LoadTexture(const char* filePath, float* width, float* height){
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
+	if (rgba != NULL){
+		rgba->assign(image, image + w * h * 4);
+	}
+
+	if (hot_reload){
+		std::string path = filePath;
+		file_watcher.watch(path, [retTexture, path]{ reload_texture(retTexture, path.c_str()); });
+	}
+
 	stbi_image_free(image);
 	return retTexture;
 }
@@ -78,67 +173,92 @@ std::vector<float> quad_verts(float width, float height){
 
 
 
-void draw_text(std::string text, float x, float y, int fontTexture, float size, float spacing){
+//Top left uv of every glyph in the 16x16 font sheet
+struct GlyphTable {
+	float u[256];
+	float v[256];
+};
 
+constexpr GlyphTable make_glyph_table(){
+	GlyphTable table{};
+	for (int i = 0; i < 256; i++){
+		table.u[i] = (float)(i % 16) / 16.0f;
+		table.v[i] = (float)(i / 16) / 16.0f;
+	}
+	return table;
+}
 
+constexpr GlyphTable font_glyphs = make_glyph_table();
+static_assert(font_glyphs.u['A'] == 1.0f / 16.0f && font_glyphs.v['A'] == 4.0f / 16.0f, "font_glyphs layout");
 
+//Writes 12 position and 12 uv floats per character, positions are relative to the first glyph
+void build_text_glyphs(const char* text, int length, float size, float spacing, float* vertexData, float* texCoordData){
 	float texture_size = 1.0 / 16.0f;
 
-	std::vector<float> vertexData;
-	std::vector<float> texCoordData;
+	for (int i = 0; i < length; i++){
+		unsigned char spriteIndex = (unsigned char)text[i];
+		float texture_x = font_glyphs.u[spriteIndex];
+		float texture_y = font_glyphs.v[spriteIndex];
 
-	for (int i = 0; i < text.size(); i++){
-		int spriteIndex = (int)text[i];
-		float texture_x = (float)(spriteIndex % 16) / 16.0f;
-		float texture_y = (float)(spriteIndex / 16) / 16.0f;
-
-		vertexData.insert(vertexData.end(), {
+		float glyph_verts[12] = {
 			((spacing * i) + (-0.5f * size)), 0.5f * size,
 			((spacing * i) + (-0.5f * size)), -0.5f * size,
 			((spacing * i) + (0.5f * size)), 0.5f * size,
 			((spacing * i) + (0.5f * size)), -0.5f * size,
 			((spacing * i) + (0.5f * size)), 0.5f * size,
 			((spacing * i) + (-0.5f * size)), -0.5f * size,
-		});
+		};
 
 
-		texCoordData.insert(texCoordData.end(), {
+		float glyph_tex_coords[12] = {
 			texture_x, texture_y,
 			texture_x, texture_y + texture_size,
 			texture_x + texture_size, texture_y,
 			texture_x + texture_size, texture_y + texture_size,
 			texture_x + texture_size, texture_y,
 			texture_x, texture_y + texture_size
-		});
+		};
+
+		memcpy(vertexData + i * 12, glyph_verts, sizeof(glyph_verts));
+		memcpy(texCoordData + i * 12, glyph_tex_coords, sizeof(glyph_tex_coords));
 	}
+}
 
 
+void draw_text(const char* text, int length, float x, float y, int fontTexture, float size, float spacing){
+	//Scratch buffers only live for this draw call, so they come from the frame arena
+	frame_vector<float> vertexData(length * 12);
+	frame_vector<float> texCoordData(length * 12);
+	build_text_glyphs(text, length, size, spacing, vertexData.data(), texCoordData.data());
 
-	modelMatrix.Identity();
-	modelMatrix.Translate(x, y, 0);
-	tex_program->SetModelMatrix(modelMatrix);
-	tex_program->SetProjectionMatrix(projectionMatrix);
-	tex_program->SetViewMatrix(viewMatrix);
-	glUseProgram(tex_program->programID);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+	tex_program->SetTransform2D(Affine2D::Translation(x, y));
+	GL_STATE(glUseProgram(tex_program->programID));
+	GL_STATE(glBindTexture(GL_TEXTURE_2D, fontTexture));
+	GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 	//Draws sprites pixel perfect with no blur
-	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	GL_STATE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 
-	glVertexAttribPointer(tex_program->positionAttribute, 2, GL_FLOAT, false, 0, vertexData.data());
+	vertex_stream->upload(vertexData.data(), vertexData.size(), texCoordData.data(), texCoordData.size());
+	glVertexAttribPointer(tex_program->positionAttribute, 2, GL_FLOAT, false, 0, vertex_stream->offset(0));
 	glEnableVertexAttribArray(tex_program->positionAttribute);
 
-	glVertexAttribPointer(tex_program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoordData.data());
+	glVertexAttribPointer(tex_program->texCoordAttribute, 2, GL_FLOAT, false, 0, vertex_stream->offset(1));
 	glEnableVertexAttribArray(tex_program->texCoordAttribute);
 
-	glBindTexture(GL_TEXTURE_2D, fontTexture);
-	glDrawArrays(GL_TRIANGLES, 0, text.size() * 6);
+	glDrawArrays(GL_TRIANGLES, 0, length * 6);
+	count_draw_call();
 
 	glDisableVertexAttribArray(tex_program->positionAttribute);
 	glDisableVertexAttribArray(tex_program->texCoordAttribute);
 
 }
 
+void draw_text(const char* text, float x, float y, int fontTexture, float size, float spacing){
+	draw_text(text, strlen(text), x, y, fontTexture, size, spacing);
+}
+
 
 class Sprite{
 public:
@@ -176,6 +296,8 @@ public:
 		sheet = true;
 	}
 
+	Sprite(GLuint texture_id_, const SheetRect& rect, float size_) : Sprite(texture_id_, rect.u, rect.v, rect.width, rect.height, size_){}
+
 
 	void set_size(int x_size_, int y_size_){
 		x_size = x_size_;
@@ -192,14 +314,16 @@ public:
 
 
 	void draw(){
-		glUseProgram(tex_program->programID);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		GL_STATE(glUseProgram(tex_program->programID));
+		GL_STATE(glBindTexture(GL_TEXTURE_2D, texture_id));
+		GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+		GL_STATE(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
 		//Draws sprites pixel perfect with no blur
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		GL_STATE(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
 
 
-		std::vector<float> verts = {
+		//One quad is small and fixed size, so it stays on the stack
+		float verts[12] = {
 			-x_size, -y_size,
 			x_size, -y_size,
 			x_size, y_size,
@@ -208,7 +332,7 @@ public:
 			-x_size, y_size
 		};
 
-		std::vector<float> texCoords = {
+		float texCoords[12] = {
 			0.0f, 1.0f,
 			1.0f, 1.0f,
 			1.0f, 0.0f,
@@ -218,35 +342,38 @@ public:
 		};
 
 		if (sheet){
-			texCoords = {
-				u, v + height,
-				u + width, v,
-				u, v,
-				u + width, v,
-				u, v + height,
-				u + width, v + height
-			};
 			float aspect = width / height;
-			verts = {
+			float sheet_verts[12] = {
 				-0.5f * size * aspect, -0.5f * size,
 				0.5f * size * aspect, 0.5f * size,
 				-0.5f * size * aspect, 0.5f * size,
 				0.5f * size * aspect, 0.5f * size,
 				-0.5f * size * aspect, -0.5f * size,
 				0.5f * size * aspect, -0.5f * size };
+			float sheet_tex_coords[12] = {
+				u, v + height,
+				u + width, v,
+				u, v,
+				u + width, v,
+				u, v + height,
+				u + width, v + height
+			};
+			memcpy(verts, sheet_verts, sizeof(verts));
+			memcpy(texCoords, sheet_tex_coords, sizeof(texCoords));
 		}
 
 
 
 
-		glVertexAttribPointer(tex_program->positionAttribute, 2, GL_FLOAT, false, 0, verts.data());
+		vertex_stream->upload(verts, 12, texCoords, 12);
+		glVertexAttribPointer(tex_program->positionAttribute, 2, GL_FLOAT, false, 0, vertex_stream->offset(0));
 		glEnableVertexAttribArray(tex_program->positionAttribute);
 
-		glVertexAttribPointer(tex_program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords.data());
+		glVertexAttribPointer(tex_program->texCoordAttribute, 2, GL_FLOAT, false, 0, vertex_stream->offset(1));
 		glEnableVertexAttribArray(tex_program->texCoordAttribute);
 
-		glBindTexture(GL_TEXTURE_2D, texture_id);
 		glDrawArrays(GL_TRIANGLES, 0, 6);
+		count_draw_call();
 
 		glDisableVertexAttribArray(tex_program->positionAttribute);
 		glDisableVertexAttribArray(tex_program->texCoordAttribute);
@@ -254,6 +381,26 @@ public:
 	}
 
 
+	//Half extents of the drawn quad in world units
+	float half_width() const{
+		return sheet ? 0.5f * size * (width / height) : x_size;
+	}
+
+	float half_height() const{
+		return sheet ? 0.5f * size : y_size;
+	}
+
+	//Same quad as draw(), centered on (x, y), queued into a batch instead
+	void add_to_batch(SpriteBatch& batch, float x, float y) const{
+		if (sheet){
+			batch.add(texture_id, x, y, half_width(), half_height(), u, v, u + width, v + height);
+		}
+		else{
+			batch.add(texture_id, x, y, x_size, y_size, 0.0f, 0.0f, 1.0f, 1.0f);
+		}
+	}
+
+
 };
 
 
@@ -307,56 +454,67 @@ public:
 
 	
 
+	//Frame shown after `time_alive` seconds, for entities that share this animation
+	int frame_at(float time_alive) const{
+		if (sprites.size() <= 1){
+			return 0;
+		}
+		return (int)(time_alive / interval) % sprites.size();
+	}
+
 	void draw(){
 		sprites[current_index].draw();
 	}
 
+	void draw(int frame){
+		sprites[frame].draw();
+	}
+
 };
 
 
 
 
-float radians_to_degrees(float radians) {
-	return radians * (180.0 / M_PI);
-}
+enum EntityType { ENTITY_GENERIC, ENTITY_PLAYER, ENTITY_ENEMY, ENTITY_BULLET, ENTITY_BARRIER, ENTITY_BACKGROUND };
+enum DrawMode { DRAW_TEXTURE, DRAW_SHAPE };
+enum Team { TEAM_NONE, TEAM_HERO, TEAM_ENEMY };
 
-float degrees_to_radians(float degrees){
-	return ((degrees)* M_PI / 180.0);
+
+//Every animation in the game lives here, entities only keep an index into it
+std::vector<Animation> animation_table;
+
+int register_animation(const Animation& animation){
+	animation_table.push_back(animation);
+	return animation_table.size() - 1;
 }
 
 
-class GameObject{
+//Plain-data entity: no heap members and no vtable so it can be memcpy'd,
+//and exactly one cache line so it never straddles two.
+//Per-type behaviour lives in update_entity() instead of virtual overrides.
+class alignas(64) GameObject{
 public:
-	std::string name = "";
-	float last_change = 0;
-	float interval = .085; //milliseconds (ms)
-
-	std::unordered_map<std::string, Animation> animations;
-	std::unordered_map<std::string, std::string> strings;
-	std::string current_animation_name = "";
-	float pos[3];
-	float start_pos[3];
-	float color[4];
-	std::vector<float> verts;
-	std::string draw_mode = "texture";
-	bool apply_velocity = true;
-	float size[3];
-	float velocity[3];
-
-	float direction[3];
-	float total_move_amount = 0;
-	float movement_angle = degrees_to_radians (-180);
-	float life = 10;
-	int lives = 2;
+	float pos[3] = { 0, 0, 0 };
+	float start_pos[2] = { 0, 0 };
+	float size[2] = { 0, 0 };
+	float velocity[2] = { 0, 0 };
+	float direction[2] = { 0, 0 };
+	float created_at = 0;
+	uint32_t color = 0xFFFFFFFF; //RGBA8, see set_color()
+	uint16_t animation = 0; //index into animation_table
+	int8_t lives = 2;
+	uint8_t frame = 0; //current sprite of the animation
+	uint8_t type = ENTITY_GENERIC;
+	uint8_t draw_mode = DRAW_TEXTURE;
+	uint8_t team = TEAM_NONE;
 	bool destroyed = false;
+	bool apply_velocity = true;
+	uint8_t slot = 0; //index into a per-type side table, the barrier_atlas entry for barriers
 
 
-	float created_at = 0;
-
 	void init(){
 		created_at = get_runtime();
 		set_pos(0, 0);
-		set_animation("idle");
 	}
 
 
@@ -364,17 +522,15 @@ public:
 		init();
 	}
 
-	GameObject(const std::string& name_){
+	GameObject(EntityType type_){
 		init();
-		
-		name = name_;
 
-		
+		type = type_;
 	}
 
 
-	void set_name(const std::string& str_){
-		name = str_;
+	void set_type(EntityType type_){
+		type = type_;
 	}
 
 
@@ -394,26 +550,16 @@ public:
 		if (initial){
 			start_pos[0] = x;
 			start_pos[1] = y;
-			start_pos[2] = z;
 		}
 	}
 
-	float timeAlive(){
+	float timeAlive() const{
 		return get_runtime() - created_at;
 	}
 
-	void add_animation(const std::string& animation_name, int animation_count){
-		Animation run_animation(name + "_" + animation_name, animation_count);
-		animations[animation_name] = run_animation;
-	}
-
-
-	void add_animation(const std::string& animation_name, Animation animation){
-		animations[animation_name] = animation;
-	}
-
-	void set_animation(const std::string& animation_name){
-		current_animation_name = animation_name;
+	void set_animation(int animation_id){
+		animation = animation_id;
+		frame = 0;
 	}
 
 	void move_y(float delta_y){
@@ -451,23 +597,6 @@ public:
 		pos[1] = y_;
 	}
 
-	virtual void update(){	
-		//pos[0] += std::cosf(movement_angle) * elapsed * 1.0f;
-		//pos[1] += std::sinf(movement_angle) * elapsed * 1.0f;
-
-		if (apply_velocity){
-
-
-			pos[0] += direction[0] * elapsed * velocity[0];
-			pos[1] += direction[1] * elapsed * velocity[1];
-		}
-
-
-		if (animations.count(current_animation_name)){
-			animations[current_animation_name].update();
-		}
-	}
-
 
 	void set_direction_x(float x_){
 		direction[0] = x_;
@@ -482,96 +611,87 @@ public:
 		direction[1] = y_;
 	}
 
-	float x(){
+	float x() const{
 		return pos[0];
 	}
 
-	float y(){
+	float y() const{
 		return pos[1];
 	}
 
-	float z(){
+	float z() const{
 		return pos[2];
 	}
 
 
-	float top_left_x(){
+	float top_left_x() const{
 		return pos[0] - (size[0] / 2);
 	}
 
-	float top_left_y(){
+	float top_left_y() const{
 		return pos[1] - (size[1] / 2);
 	}
 
-	void set_verts(std::vector<float> arr){
-		verts = arr;
-	}
-
 
 	void set_size(float width_, float height_){
 		size[0] = width_;
 		size[1] = height_;
 	}
 
-	void set_draw_mode(std::string mode_){
+	void set_draw_mode(DrawMode mode_){
 		draw_mode = mode_;
 	}
 
-	void set_velocity(float x_, float y_, float z_=0){
+	void set_velocity(float x_, float y_){
 		velocity[0] = x_;
 		velocity[1] = y_;
-		velocity[2] = z_;
 	}
 
 
 	void set_color(float r, float g, float b, float a){
-		color[0] = r;
-		color[1] = g;
-		color[2] = b;
-		color[3] = a;
+		color = ((uint32_t)(r * 255.0f) << 24) | ((uint32_t)(g * 255.0f) << 16) | ((uint32_t)(b * 255.0f) << 8) | (uint32_t)(a * 255.0f);
 	}
 
+	float color_channel(int channel) const{
+		return ((color >> (24 - channel * 8)) & 0xFF) / 255.0f;
+	}
 
 
-	void draw(){
+
+	void draw() const{
 		if (destroyed){
 			return;
 		}
 		
-		if (draw_mode == "texture"){
-			
-			tex_program->SetModelMatrix(modelMatrix);
-			tex_program->SetProjectionMatrix(projectionMatrix);
-			tex_program->SetViewMatrix(viewMatrix);
-					
-
-			if (animations.count(current_animation_name)){
-				modelMatrix.Identity();
-				modelMatrix.Translate(x(), y(), z());
-				tex_program->SetModelMatrix(modelMatrix);
-				tex_program->SetViewMatrix(viewMatrix);
+		if (draw_mode == DRAW_TEXTURE){
+			if (animation < animation_table.size()){
+				tex_program->SetTransform2D(Affine2D::Translation(x(), y()));
 				tex_program->SetColor(0,1,0,1);
 
 
-				glUseProgram(tex_program->programID);
-				animations[current_animation_name].draw();
+				GL_STATE(glUseProgram(tex_program->programID));
+				animation_table[animation].draw(frame);
 			}
 		}
-		else if (draw_mode == "shape"){
-			shape_program->SetModelMatrix(modelMatrix);
-			shape_program->SetProjectionMatrix(projectionMatrix);
-			shape_program->SetViewMatrix(viewMatrix);
-			glUseProgram(shape_program->programID);
+		else if (draw_mode == DRAW_SHAPE){
+			GL_STATE(glUseProgram(shape_program->programID));
 
 
-			modelMatrix.Identity();
-			modelMatrix.Translate(x(), y(), z());
-			shape_program->SetModelMatrix(modelMatrix);	
-			shape_program->SetColor(color[0], color[1], color[2], color[3]);
+			shape_program->SetTransform2D(Affine2D::Translation(x(), y()));
+			shape_program->SetColor(color_channel(0), color_channel(1), color_channel(2), color_channel(3));
 
-			glVertexAttribPointer(shape_program->positionAttribute, 2, GL_FLOAT, false, 0, verts.data());
+			float verts[] = {
+				-size[0] / 2, size[1] / 2, //top left
+				-size[0] / 2, -size[1] / 2, // bottom left
+				size[0] / 2, -size[1] / 2, //bottom right
+				size[0] / 2, size[1] / 2 //top right
+			};
+
+			vertex_stream->upload(verts, 8);
+			glVertexAttribPointer(shape_program->positionAttribute, 2, GL_FLOAT, false, 0, vertex_stream->offset(0));
 			glEnableVertexAttribArray(shape_program->positionAttribute);
-			glDrawArrays(GL_QUADS, 0, 4);
+			draw_indexed_quad();
+			count_draw_call();
 
 			glDisableVertexAttribArray(shape_program->positionAttribute);
 		}
@@ -581,29 +701,41 @@ public:
 
 
 
-	float width(){
+	//Queues the current sprite into a batch, returns false for objects the batch can't draw
+	bool add_to_batch(SpriteBatch& batch) const{
+		if (destroyed){
+			return true;
+		}
+
+		if (draw_mode != DRAW_TEXTURE || animation >= animation_table.size()){
+			return false;
+		}
+
+		animation_table[animation].sprites[frame].add_to_batch(batch, x(), y());
+		return true;
+	}
+
+
+	float width() const{
 		return size[0];
 	}
 
 
-	float height(){
+	float height() const{
 		return size[1];
 	}
 
 
 
-	GameObject shoot(Animation animation){
-		GameObject newBullet;
+	GameObject shoot(int bullet_animation) const{
+		GameObject newBullet(ENTITY_BULLET);
 		newBullet.set_pos(x(), y());
 		newBullet.set_velocity(0, 3.0f);
 		newBullet.set_direction(direction[0], direction[1]);
-		newBullet.set_draw_mode("texture");
+		newBullet.set_draw_mode(DRAW_TEXTURE);
 		newBullet.set_size(0.1, 0.1);
-		newBullet.set_verts(quad_verts(0.1, 0.1));
-		newBullet.strings["shooter_name"] = name;
-
-		newBullet.add_animation("idle", animation);
-		newBullet.set_animation("idle");
+		newBullet.team = team;
+		newBullet.set_animation(bullet_animation);
 
 		return newBullet;
 	}
@@ -613,28 +745,52 @@ public:
 
 };
 
+static_assert(sizeof(GameObject) == 64, "GameObject must stay exactly one cache line");
+static_assert(alignof(GameObject) == 64, "GameObject must be cache line aligned");
+static_assert(std::is_trivially_copyable<GameObject>::value, "GameObject must be memcpy-able");
 
-class Barrier : public GameObject {
-public:
-	Barrier():GameObject() {
-
-	}
 
 
-	virtual void update() override {
-
+//Distance obj covers in seconds at its current velocity
+void entity_motion(const GameObject& obj, float seconds, float* dx, float* dy){
+	if (obj.apply_velocity){
+		*dx = obj.direction[0] * seconds * obj.velocity[0];
+		*dy = obj.direction[1] * seconds * obj.velocity[1];
 	}
+	else{
+		*dx = 0;
+		*dy = 0;
+	}
+}
 
-
-	void advance_active_animation(){
-		if (animations[current_animation_name].current_index >= 4){
-			destroyed = true;
+//Entity systems, dispatched on GameObject::type
+void update_entity(GameObject& obj){
+	switch (obj.type){
+		case ENTITY_BARRIER:
+			//Barriers are static, their damage lives in GameLevel::barrier_atlas
+			break;
+		case ENTITY_BACKGROUND:
+			//Drawn once into GameLevel::static_layer, must not move
+			break;
+		default:{
+			float dx, dy;
+			entity_motion(obj, elapsed, &dx, &dy);
+			obj.pos[0] += dx;
+			obj.pos[1] += dy;
+
+			if (obj.animation < animation_table.size()){
+				obj.frame = animation_table[obj.animation].frame_at(obj.timeAlive());
+			}
+			break;
 		}
-		else{
-			animations[current_animation_name].advance();
-		}		
 	}
-};
+}
+
+void update_entities(GameObject* objs, int count){
+	for (int i = 0; i < count; i++){
+		update_entity(objs[i]);
+	}
+}
 
 
 bool check_box_collision(float x1, float y1, float w1, float h1, float x2, float y2, float w2, float h2){
@@ -652,7 +808,7 @@ bool check_box_collision(float x1, float y1, float w1, float h1, float x2, float
 	}	
 }
 
-bool check_box_collision(GameObject& obj1, GameObject& obj2){
+bool check_box_collision(const GameObject& obj1, const GameObject& obj2){
 	if (obj1.destroyed){
 		return false;
 	}
@@ -665,6 +821,61 @@ bool check_box_collision(GameObject& obj1, GameObject& obj2){
 }
 
 
+//Swept AABB: box 1 moves by (dx, dy) while box 2 stays put. Returns the earliest
+//fraction 0..1 of the move at which they touch (0 if they already overlap), or -1
+float swept_box_collision(float x1, float y1, float w1, float h1, float dx, float dy, float x2, float y2, float w2, float h2){
+	float t_enter = 0.0f;
+	float t_exit = 1.0f;
+
+	if (dx == 0.0f){
+		if (x1 + w1 < x2 || x1 > x2 + w2){
+			return -1.0f;
+		}
+	}
+	else{
+		float t_near = (x2 - (x1 + w1)) / dx;
+		float t_far = (x2 + w2 - x1) / dx;
+		if (t_near > t_far){
+			std::swap(t_near, t_far);
+		}
+		t_enter = std::max(t_enter, t_near);
+		t_exit = std::min(t_exit, t_far);
+	}
+
+	if (dy == 0.0f){
+		if (y1 + h1 < y2 || y1 > y2 + h2){
+			return -1.0f;
+		}
+	}
+	else{
+		float t_near = (y2 - (y1 + h1)) / dy;
+		float t_far = (y2 + h2 - y1) / dy;
+		if (t_near > t_far){
+			std::swap(t_near, t_far);
+		}
+		t_enter = std::max(t_enter, t_near);
+		t_exit = std::min(t_exit, t_far);
+	}
+
+	if (t_enter > t_exit){
+		return -1.0f;
+	}
+	return t_enter;
+}
+
+//Tests the path moving covered during the last tick against target, which is treated as static
+float swept_box_collision(const GameObject& moving, const GameObject& target){
+	if (moving.destroyed || target.destroyed){
+		return -1.0f;
+	}
+
+	float dx, dy;
+	entity_motion(moving, elapsed, &dx, &dy);
+	return swept_box_collision(moving.top_left_x() - dx, moving.top_left_y() - dy, moving.width(), moving.height(), dx, dy,
+		target.top_left_x(), target.top_left_y(), target.width(), target.height());
+}
+
+
 
 
 
@@ -678,7 +889,6 @@ public:
 
 	GameObject player;
 
-	std::vector<GameObject> enemies;
 	std::vector<GameObject> bullets;
 
 	int score;
@@ -698,6 +908,35 @@ public:
 };
 
 
+bool show_alloc_overlay = false;
+bool show_perf_overlay = false;
+
+//Keys that work on every screen, called from each state's event loop
+void handle_debug_keys(const SDL_Event& event){
+	if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F1){
+		show_perf_overlay = !show_perf_overlay;
+	}
+	if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F2){
+		show_alloc_overlay = !show_alloc_overlay;
+	}
+}
+
+
+//Heap usage of the last frame, broken down by ALLOC_TAG
+void draw_alloc_overlay(){
+	const AllocStats& frame = alloc_last_frame_stats();
+	float y = 1.6f;
+	draw_text(frame_sprintf("heap: %u new %u delete %u bytes live %u", frame.allocs, frame.frees, (unsigned int)frame.bytes_allocated, (unsigned int)alloc_live_bytes()), -3.4f, y, font_texture, 0.2f, 0.09f);
+
+	const AllocTagStats* tags;
+	int tag_count = alloc_last_frame_tags(&tags);
+	for (int i = 0; i < tag_count; i++){
+		y -= 0.15f;
+		draw_text(frame_sprintf("  %s: %u new %u bytes", tags[i].tag, tags[i].stats.allocs, (unsigned int)tags[i].stats.bytes_allocated), -3.4f, y, font_texture, 0.2f, 0.09f);
+	}
+}
+
+
 class MainMenu : GameState {
 public:
 	void render(){
@@ -717,6 +956,8 @@ public:
 			if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
 				done = true;
 			}
+			handle_debug_keys(event);
+			frame_pacer.note_input(event);
 
 
 			if (event.type == SDL_KEYDOWN){
@@ -730,11 +971,33 @@ public:
 };
 
 
-bool shouldRemoveBullet(GameObject bullet) {
+//Tests the drawn quad against view, sprites can be larger than the hitbox
+bool in_view(const GameObject& obj, const ViewBounds& view){
+	float half_width = obj.width() / 2;
+	float half_height = obj.height() / 2;
+
+	if (obj.draw_mode == DRAW_TEXTURE && obj.animation < animation_table.size()){
+		const Sprite& sprite = animation_table[obj.animation].sprites[obj.frame];
+		half_width = std::max(half_width, sprite.half_width());
+		half_height = std::max(half_height, sprite.half_height());
+	}
+
+	return check_box_collision(obj.x() - half_width, obj.y() - half_height, half_width * 2, half_height * 2,
+		view.left, view.bottom, view.right - view.left, view.top - view.bottom);
+}
+
+
+
+bool shouldRemoveBullet(const GameObject& bullet) {
 	if (bullet.timeAlive() > 2) {
 		return true;
 	}
 
+	//Nothing outside the playfield can be hit, so retire bullets as soon as they leave it
+	if (!in_view(bullet, playfield)){
+		return true;
+	}
+
 
 	if (bullet.destroyed){
 		return true;
@@ -745,20 +1008,16 @@ bool shouldRemoveBullet(GameObject bullet) {
 }
 
 
-bool shouldRemoveEnemy(GameObject enemy) {
+bool shouldRemoveEnemy(const GameObject& enemy) {
 	if (enemy.destroyed){
 		return true;
 	}
 
-	if (enemy.life == 0){
-		return true;
-	}
-
 	return false;
 }
 
-bool shouldRemoveBarrier(Barrier* barrier){
-	if (barrier->destroyed){
+bool shouldRemoveBarrier(const GameObject& barrier){
+	if (barrier.destroyed){
 		return true;
 	}
 
@@ -767,135 +1026,236 @@ bool shouldRemoveBarrier(Barrier* barrier){
 
 
 
-class GameLevel : GameState {
+//resources/sheet.png layout, the uv fractions are computed at compile time
+constexpr float sheet_size = 480.0f;
+constexpr SheetRect sheet_player = sheet_rect(sheet_size, sheet_size, 0.0f, 0.0f, 16.0f, 16.0f);
+constexpr SheetRect sheet_player_bullet = sheet_rect(sheet_size, sheet_size, 112.0f, 0.0f, 16.0f, 16.0f);
+constexpr SheetRect sheet_enemy_bullet = sheet_rect(sheet_size, sheet_size, 128.0f, 0.0f, 16.0f, 16.0f);
+//Undamaged barrier, BARRIER_MASK_WIDTH x BARRIER_MASK_HEIGHT texels, copied into GameLevel::barrier_atlas
+constexpr int sheet_barrier_x = 0;
+constexpr int sheet_barrier_y = 48;
+static_assert(sheet_player_bullet.u == 112.0f / 480.0f && sheet_player_bullet.width == 16.0f / 480.0f, "sheet_player_bullet");
+
+
+//Waves are played in order from resources/waves/wave1.wave, wave2.wave, ... until one is missing
+const char* wave_path(int number){
+	return frame_sprintf("resources/waves/wave%d.wave", number);
+}
+
+class GameLevel : public GameState {
 public:
 	GLuint sprite_sheet_texture;
 	
 	float sheet_width = 0;
 	float sheet_height = 0;
 
-	std::vector<GameObject*> objects;
-	std::vector<Barrier*> barriers;
+	std::vector<GameObject> objects;
+	std::vector<GameObject> barriers;
 	int score = 0;
-	int enemies_per_row = 11;
+
+	int player_bullet_animation;
+	int enemy_bullet_animation;
+
+	SpriteBatch sprite_batch{ 512 };
+
+	//Per-texel barrier damage, see barrier_take_hit
+	BarrierAtlas barrier_atlas;
+
+	//The enemy grid: alive bits and per-row offsets, a movement step touches one row offset
+	Formation formation;
+	//Look of every enemy in a row (animation, size, team), positioned from the formation when used
+	GameObject enemy_rows[FORMATION_MAX_ROWS];
+
+	//Background and barriers, redrawn only when a barrier changes
+	StaticLayer static_layer{ window_width, window_height };
+
+	//The wave being played and the one after it, read by the first update() of this one
+	//so the file access doesn't land on the frame that lays out the new wave.
+	//Advancing flips current_wave_slot, the files stay where they were loaded.
+	int wave_number = 0;
+	WaveFile wave_files[2];
+	int current_wave_slot = 0;
+	bool next_wave_pending = false;
+	WaveFile& current_wave(){ return wave_files[current_wave_slot]; }
+	WaveFile& next_wave(){ return wave_files[1 - current_wave_slot]; }
+	//animation_table slots reused by every wave, each holds one sprite that start_wave overwrites
+	int row_animations[FORMATION_MAX_ROWS];
+	int barrier_animations[WAVE_MAX_BARRIERS];
+	static_assert(WAVE_MAX_BARRIERS <= BARRIER_ATLAS_CAPACITY, "every barrier a wave file can hold fits in the atlas");
+	//Undamaged barrier texels from the sheet, every wave's barriers start from these
+	unsigned char barrier_pixels[BARRIER_MASK_WIDTH * BARRIER_MASK_HEIGHT * 4];
 
 	GameLevel(){
-		sprite_sheet_texture = LoadTexture("resources/sheet.png", &sheet_width, &sheet_height);
+		std::vector<unsigned char> sheet_pixels;
+		sprite_sheet_texture = LoadTexture("resources/sheet.png", &sheet_width, &sheet_height, &sheet_pixels);
+		if (sheet_width != sheet_size || sheet_height != sheet_size){
+			std::cout << "resources/sheet.png is " << sheet_width << "x" << sheet_height << ", expected " << sheet_size << "x" << sheet_size << std::endl;
+		}
 		
 
 		float player_width = 0.35;
 		float player_height = 0.35;
 
-		player.set_name("hero");
+		player.set_type(ENTITY_PLAYER);
+		player.team = TEAM_HERO;
 		player.set_pos(0, -1.68f);
-		player.set_draw_mode("texture");
+		player.set_draw_mode(DRAW_TEXTURE);
 		player.set_velocity(3, 3);
 		player.apply_velocity = false;
 		player.set_size(player_width, player_height);
-		player.set_verts(quad_verts(player_width, player_height));
 		player.set_direction(0, 1.0f);
 
 		Animation player_animation;
-		Sprite player_sprite(sprite_sheet_texture, 0.0f / sheet_width, 0.0f / sheet_height, 16.0f / sheet_width, 16.0f / sheet_height, 0.35);
+		Sprite player_sprite(sprite_sheet_texture, sheet_player, 0.35);
 		
 		player_animation.add_sprite(player_sprite);
 
-		player.add_animation("idle", player_animation);
-		player.set_animation("idle");
-
+		player.set_animation(register_animation(player_animation));
 
-		float enemy_spawn_start_x = -2.44f;
-		float enemy_spawn_start_y = 1.5f;
-		float enemy_spawn_spacing = (3.5 * 2) / 13;
-		float enemy_spawn_y_spacing = 0.46f;
-		float sheet_x_offsets[] = {16.0f, 32.0f, 32.0f, 48.0f, 48.0f};
-		int current_row_index = 0;
-		for (int x = 0; x < enemies_per_row * 5; x++){
-			int x_relative = x % enemies_per_row;
-			if (x != 0 && x % enemies_per_row == 0){
-				current_row_index += 1;
-			}
 
+		Animation player_bullet;
+		player_bullet.add_sprite(Sprite(sprite_sheet_texture, sheet_player_bullet, 0.35));
+		player_bullet_animation = register_animation(player_bullet);
 
-			float this_spawn_x = enemy_spawn_start_x + (x_relative * enemy_spawn_spacing);
-			float this_spawn_y = enemy_spawn_start_y - (current_row_index * enemy_spawn_y_spacing);
-			GameObject new_enemy;
-			new_enemy.set_pos(this_spawn_x, this_spawn_y, 0, true);
-			new_enemy.set_draw_mode("texture");
-			new_enemy.set_velocity(0, 0);
-			new_enemy.apply_velocity = false;
-			new_enemy.set_size(0.44, 0.44);
-			new_enemy.set_verts(quad_verts(player_width, player_height));
-			new_enemy.set_direction(0, -1.0f);
-
-			Animation enemy_animation;
-			Sprite enemy_sprite(sprite_sheet_texture, sheet_x_offsets[current_row_index] / sheet_width, 0.0f / sheet_height, 16.0f / sheet_width, 16.0f / sheet_height, 0.44);
-
-			enemy_animation.add_sprite(enemy_sprite);
-
-			new_enemy.add_animation("idle", enemy_animation);
-			new_enemy.set_animation("idle");
-			enemies.push_back(new_enemy);
-			
-		}
+		Animation enemy_bullet;
+		enemy_bullet.add_sprite(Sprite(sprite_sheet_texture, sheet_enemy_bullet, 0.35));
+		enemy_bullet_animation = register_animation(enemy_bullet);
 
 
-
-		GameObject* background = new GameObject("background");
-		background->set_pos(0, 0);
-		background->set_draw_mode("texture");
-		background->set_color(0.5, 0.3, 0, 1);
-		background->set_size(3.55 * 1.2f, 2.0 * 1.2f);
-		background->set_verts(quad_verts(background->width(), background->height()));
+		GameObject background(ENTITY_BACKGROUND);
+		background.set_pos(0, 0);
+		background.set_draw_mode(DRAW_TEXTURE);
+		background.set_color(0.5, 0.3, 0, 1);
+		background.set_size(3.55 * 1.2f, 2.0 * 1.2f);
 
 		Animation background_animation;
 		Sprite background_sprite("resources/space.jpg");
-		background_sprite.set_size(background->width(), background->height());
+		background_sprite.set_size(background.width(), background.height());
 		background_animation.add_sprite(background_sprite);
 
-		background->add_animation("idle", background_animation);
-		background->set_animation("idle");
+		background.set_animation(register_animation(background_animation));
 		objects.push_back(background);
 
 
 
 
-		//Barriers
-		float barrier_x_spacing = 2.23f;
-		for (int z = 0; z < 3; z++){
-			Barrier* barrier_1 = new Barrier();
-			barrier_1->set_pos(-2.3f + (barrier_x_spacing * z), -1.3f);
-			barrier_1->set_draw_mode("texture");
-			barrier_1->set_size(1, 0.5f);
-			barrier_1->set_verts(quad_verts(background->width(), background->height()));
+		copy_barrier_pixels(&sheet_pixels[0], (int)sheet_width);
+		//The texture reloads itself, the atlas holds its own copy of the barrier and needs rebuilding
+		if (hot_reload){
+			file_watcher.watch("resources/sheet.png", [this]{ reload_barriers(); });
+		}
+		//Built here so a wave change mid-game only copies sprites, nothing is allocated
+		Animation placeholder;
+		placeholder.add_sprite(Sprite(sprite_sheet_texture, sheet_player, 0.0f));
+		for (int i = 0; i < FORMATION_MAX_ROWS; i++){
+			row_animations[i] = register_animation(placeholder);
+		}
+		for (int i = 0; i < WAVE_MAX_BARRIERS; i++){
+			barrier_animations[i] = register_animation(placeholder);
+		}
 
-			Animation barrier_animation;
-			float barrier_sheet_y = 48;
-			for (int x = 0; x < 5; x++){
-				Sprite barrier_sprite_1(sprite_sheet_texture, (32 * x) / sheet_width, barrier_sheet_y / sheet_height, 32.0f / sheet_width, 16.0f / sheet_height, 0.44);
-				barrier_animation.add_sprite(barrier_sprite_1);
-			}
+		//Bullets only live for 2 seconds, reserving up front keeps shooting off the heap
+		bullets.reserve(256);
+		barriers.reserve(BARRIER_ATLAS_CAPACITY);
 
+		//Without a first wave there is nothing to play, the caller checks ready() and quits
+		wave_number = 1;
+		if (!current_wave().load(wave_path(wave_number))){
+			std::cout << "Unable to load " << wave_path(wave_number) << ". Build it from wave1.txt with --compile-wave\n";
+			return;
+		}
+		start_wave();
+	}
 
-			barrier_1->add_animation("idle", barrier_animation);
-			barrier_1->set_animation("idle");
+	bool ready() const{
+		return wave_files[current_wave_slot].loaded();
+	}
 
 
-			barriers.push_back(barrier_1);
+	void copy_barrier_pixels(const unsigned char* sheet_pixels, int width){
+		for (int y = 0; y < BARRIER_MASK_HEIGHT; y++){
+			memcpy(&barrier_pixels[y * BARRIER_MASK_WIDTH * 4], &sheet_pixels[((sheet_barrier_y + y) * width + sheet_barrier_x) * 4], BARRIER_MASK_WIDTH * 4);
 		}
-
 	}
 
+	//--hot-reload of sheet.png. Every atlas slot is rebuilt from the new art, so the
+	//barriers still standing come back undamaged, the destroyed ones stay gone.
+	void reload_barriers(){
+		int w, h, comp;
+		unsigned char* image = stbi_load("resources/sheet.png", &w, &h, &comp, STBI_rgb_alpha);
+		if (image == NULL){
+			return;
+		}
+		if (w == sheet_size && h == sheet_size){
+			copy_barrier_pixels(image, w);
+			barrier_atlas.init(barrier_pixels, barrier_atlas.size());
+		}
+		stbi_image_free(image);
+	}
+
+	//Lays out the formation and barriers of current_wave and marks the next wave's file
+	//for reading. Runs mid-frame, so it must not allocate.
+	void start_wave(){
+		const WaveView& wave = current_wave().get();
+		const WaveHeader& header = *wave.header;
+
+		formation.reset(header.row_count, header.columns, header.origin[0], header.origin[1], header.spacing[0], header.spacing[1]);
+		for (int row = 0; row < formation.rows; row++){
+			const WaveRow& wave_row = wave.rows[row];
+			SheetRect rect = sheet_rect(sheet_width, sheet_height, wave_row.sheet_rect[0], wave_row.sheet_rect[1], wave_row.sheet_rect[2], wave_row.sheet_rect[3]);
+			animation_table[row_animations[row]].sprites[0] = Sprite(sprite_sheet_texture, rect, wave_row.size);
+
+			GameObject& new_enemy = enemy_rows[row];
+			new_enemy = GameObject(ENTITY_ENEMY);
+			new_enemy.team = TEAM_ENEMY;
+			new_enemy.set_pos(formation.x(row, 0), formation.y(row), 0, true);
+			new_enemy.set_draw_mode(DRAW_TEXTURE);
+			new_enemy.set_velocity(0, 0);
+			new_enemy.apply_velocity = false;
+			new_enemy.set_size(wave_row.size, wave_row.size);
+			new_enemy.set_direction(0, -1.0f);
+			new_enemy.set_animation(row_animations[row]);
+		}
 
-	~GameLevel(){
-		for (int x = 0; x < objects.size(); x++){
-			delete objects[x];
+		//wave_view already rejected files with more than WAVE_MAX_BARRIERS
+		int barrier_count = (int)header.barrier_count;
+		barrier_atlas.init(barrier_pixels, barrier_count);
+		barriers.clear();
+		for (int z = 0; z < barrier_count; z++){
+			GameObject barrier(ENTITY_BARRIER);
+			barrier.set_pos(wave.barriers[z].position[0], wave.barriers[z].position[1]);
+			barrier.set_draw_mode(DRAW_TEXTURE);
+
+			//Each barrier draws its own damaged copy, and its box is exactly the drawn quad so mask texels line up
+			Sprite barrier_sprite(barrier_atlas.texture, barrier_atlas.rect(z), wave.barriers[z].size);
+			barrier.set_size(barrier_sprite.half_width() * 2, barrier_sprite.half_height() * 2);
+			animation_table[barrier_animations[z]].sprites[0] = barrier_sprite;
+			barrier.set_animation(barrier_animations[z]);
+			barrier.slot = z;
+
+			barriers.push_back(barrier);
 		}
 
-		for (int x = 0; x < barriers.size(); x++){
-			delete barriers[x];
+		bullets.clear();
+		enemy_movement_direction = -1;
+		row_index = 0;
+		row_change_count = 0;
+		last_movement = get_runtime();
+		last_attack = get_runtime();
+		static_layer.invalidate();
+
+		next_wave_pending = true;
+	}
+
+	//Moves on to the preloaded wave, false when this was the last one
+	bool advance_wave(){
+		if (!next_wave().loaded()){
+			return false;
 		}
-		
+		current_wave_slot = 1 - current_wave_slot;
+		wave_number += 1;
+		start_wave();
+		return true;
 	}
 
 	float enemy_movement_direction = -1;
@@ -905,28 +1265,30 @@ public:
 
 	float last_movement = 0;
 	float last_attack = 0;
-	float attack_interval = 1.0f;
 
 	int row_index = 0;
 	int row_change_count = 0;
 
 	void update(){
-		player.update();
-
-		if (get_runtime() - last_movement > 0.2f){
-			int x_start = enemies.size() - 1 - (row_index * enemies_per_row);
-			int x_end = enemies.size() - 1 - (row_index * enemies_per_row) - 10;
-
-			for (int x = x_start; x >= x_end; x--){
-				enemies[x].move_x(0.1f * enemy_movement_direction);
+		PROFILE_ZONE("GameLevel::update");
+		ALLOC_TAG("GameLevel::update");
+		if (next_wave_pending){
+			next_wave().load(wave_path(wave_number + 1));
+			next_wave_pending = false;
+		}
+		update_entity(player);
 
-				enemies[x].set_y(enemies[x].start_pos[1] - ((row_change_count / 5) * 0.05f));
-			}
+		const WaveHeader& wave = *current_wave().get().header;
+		if (get_runtime() - last_movement > wave.step_interval){
+			//Rows step one at a time from the bottom up, every 5 sweeps the formation drops and turns
+			int row = formation.rows - 1 - row_index;
+			formation.row_offset_x[row] += wave.step_distance * enemy_movement_direction;
+			formation.row_offset_y[row] = -((row_change_count / 5) * wave.drop_distance);
 
 			
 			last_movement = get_runtime();
 			row_index += 1;
-			if (row_index >= enemies.size() / enemies_per_row){
+			if (row_index >= formation.rows){
 				row_change_count += 1;
 				row_index = 0;
 
@@ -937,107 +1299,167 @@ public:
 		}
 
 
-		if (get_runtime() - last_attack > attack_interval){
-			std::vector<int> enemies_capable_of_attacking;
-			for (int x = 0; x < enemies.size(); x++){
-				if (enemies[x].destroyed){
-					continue;
-				}
-
-				//If enemy is on bottom row and isnt destroyed, it is always capable of attacking
-				if (x >= enemies.size() - enemies_per_row){
-					enemies_capable_of_attacking.push_back(x);
-					continue;
-				}
+		if (get_runtime() - last_attack > wave.attack_interval){
+			//Only the bottom-most enemy of a column can shoot, pick one of the non-empty columns
+			uint64_t columns = formation.alive_columns();
+			if (columns != 0){
+				int column = nth_set_bit(columns, rand() % popcount64(columns));
+				int row = formation.lowest_alive_in_column(column);
+				GameObject shooter = enemy_rows[row];
+				shooter.set_pos(formation.x(row, column), formation.y(row));
+				enemy_shoot(shooter);
+				last_attack = get_runtime();
+			}
+		}
+		
 
 
-				bool all_enemies_below_are_destroyed = true;
-				for (int y = x + 11; y < enemies.size(); y += 11){
-					if (enemies[y].destroyed == false){
-						all_enemies_below_are_destroyed = false;
-						break;
-					}
-				}
 
 
-				if (all_enemies_below_are_destroyed){
-					enemies_capable_of_attacking.push_back(x);
-				}
-			}
+		{
+			PROFILE_ZONE("GameLevel::update entities");
+			bullets.erase(std::remove_if(bullets.begin(), bullets.end(), shouldRemoveBullet), bullets.end());
 
-			if (enemies_capable_of_attacking.size() > 0){
-				srand(time(NULL));
+			update_entities(bullets.data(), bullets.size());
+			update_entities(objects.data(), objects.size());
 
-				// Create ran int between 0 and size()
-				int random_enemy_index = rand() % enemies_capable_of_attacking.size();
-				enemy_shoot(enemies[enemies_capable_of_attacking[random_enemy_index]]);
-				last_attack = get_runtime();
-			}
-			else{
-				game_won();
-			}
+			barriers.erase(std::remove_if(barriers.begin(), barriers.end(), shouldRemoveBarrier), barriers.end());
+			update_entities(barriers.data(), barriers.size());
 		}
-		
 
+		handle_collisions();
 
+		if (!formation.any_alive() && !advance_wave()){
+			game_won();
+		}
+	}
+
+	//Earliest enemy along the path a bullet covered this tick. Enemy boxes come from the
+	//formation, and only the columns the path spans horizontally are tested.
+	float formation_sweep(const GameObject& bullet, int* hit_row, int* hit_column){
+		float dx, dy;
+		entity_motion(bullet, elapsed, &dx, &dy);
+		float start_x = bullet.top_left_x() - dx;
+		float start_y = bullet.top_left_y() - dy;
+		float path_left = std::min(start_x, start_x + dx);
+		float path_right = std::max(start_x, start_x + dx) + bullet.width();
 
+		float earliest = -1.0f;
+		for (int row = 0; row < formation.rows; row++){
+			if (formation.alive[row] == 0){
+				continue;
+			}
 
-		bullets.erase(std::remove_if(bullets.begin(), bullets.end(), shouldRemoveBullet), bullets.end());
+			const GameObject& enemy = enemy_rows[row];
+			float half_width = enemy.width() / 2;
+			float half_height = enemy.height() / 2;
+			float row_left = formation.x(row, 0);
+			int first = std::max((int)ceilf((path_left - half_width - row_left) / formation.spacing[0]), 0);
+			int last = std::min((int)floorf((path_right + half_width - row_left) / formation.spacing[0]), formation.columns - 1);
+			if (first > last){
+				continue;
+			}
 
-		for (int i = 0; i < bullets.size(); i++) {
-			bullets[i].update();
+			uint64_t candidates = formation.alive[row] & range_bits64(first, last);
+			while (candidates != 0){
+				int column = ctz64(candidates);
+				candidates &= candidates - 1;
+
+				float time = swept_box_collision(start_x, start_y, bullet.width(), bullet.height(), dx, dy,
+					formation.x(row, column) - half_width, formation.y(row) - half_height, enemy.width(), enemy.height());
+				if (time >= 0.0f && (earliest < 0.0f || time < earliest)){
+					earliest = time;
+					*hit_row = row;
+					*hit_column = column;
+				}
+			}
 		}
+		return earliest;
+	}
 
+	void enemy_shoot(const GameObject& enemy){
+		bullets.push_back(enemy.shoot(enemy_bullet_animation));
+	}
 
-		for (int i = 0; i < objects.size(); i++) {
-			objects[i]->update();
+	void batch_or_draw(const GameObject& obj, const ViewBounds& view){
+		if (obj.destroyed){
+			return;
 		}
 
+		if (!in_view(obj, view)){
+			count_culled();
+			return;
+		}
 
-		barriers.erase(std::remove_if(barriers.begin(), barriers.end(), shouldRemoveBarrier), barriers.end());
+		if (!obj.add_to_batch(sprite_batch)){
+			sprite_batch.end();
+			obj.draw();
+		}
+	}
 
-		for (int i = 0; i < barriers.size(); i++) {
-			barriers[i]->update();
+	//Everything that goes into static_layer
+	void render_static(const ViewBounds& view){
+		for (int i = 0; i < objects.size(); i++) {
+			batch_or_draw(objects[i], view);
 		}
 
-		handle_collisions();
+		for (int i = 0; i < barriers.size(); i++) {
+			batch_or_draw(barriers[i], view);
+		}
 	}
 
-	void enemy_shoot(GameObject& enemy){
-		Animation bullet_animation;
-		Sprite bullet_sprite(sprite_sheet_texture, 128.0f / sheet_width, 0.0f / sheet_height, 16.0f / sheet_width, 16.0f / sheet_height, 0.35);
+	void render(){
+		ALLOC_TAG("GameLevel::render");
 
-		bullet_animation.add_sprite(bullet_sprite);
+		//Everything is pre-transformed into one stream, one draw per texture run
+		sprite_batch.begin(tex_program, Matrix());
 
+		//Cull against whatever the projection currently shows
+		ViewBounds view = view_bounds_from_ortho(projectionMatrix);
 
-		bullets.push_back(enemy.shoot(bullet_animation));
-	}
+		barrier_atlas.upload();
 
-	void render(){
-		for (int i = 0; i < objects.size(); i++) {
-			objects[i]->draw();
+		//The background covers the whole view, so with the layer cached its copy
+		//stands in for the clear as well as for the static draws
+		if (static_layer.supported()){
+			if (!static_layer.valid()){
+				static_layer.begin();
+				render_static(view);
+				sprite_batch.end();
+				static_layer.end();
+				sprite_batch.begin(tex_program, Matrix());
+			}
+			static_layer.present();
 		}
-
-		for (int x = 0; x < enemies.size(); x++){
-			enemies[x].draw();
+		else{
+			glClear(GL_COLOR_BUFFER_BIT);
+			render_static(view);
 		}
 
+		for (int row = 0; row < formation.rows; row++){
+			GameObject enemy = enemy_rows[row];
+			uint64_t alive = formation.alive[row];
+			while (alive != 0){
+				int column = ctz64(alive);
+				alive &= alive - 1;
 
-		for (int x = 0; x < bullets.size(); x++){
-			bullets[x].draw();
+				enemy.set_pos(formation.x(row, column), formation.y(row));
+				batch_or_draw(enemy, view);
+			}
 		}
 
 
-		for (int i = 0; i < barriers.size(); i++) {
-			barriers[i]->draw();
+		for (int x = 0; x < bullets.size(); x++){
+			batch_or_draw(bullets[x], view);
 		}
 
 
 		
-		player.draw();
+		batch_or_draw(player, view);
+		sprite_batch.end();
 
-		draw_text("points: " + std::to_string(score), -3.4f, 1.859f, font_texture, 0.4, 0.165f);
-		draw_text("lives: " + std::to_string(player.lives), -3.45f, -1.849f, font_texture, 0.4, 0.165f);
+		draw_text(frame_sprintf("points: %d", score), -3.4f, 1.859f, font_texture, 0.4, 0.165f);
+		draw_text(frame_sprintf("lives: %d", player.lives), -3.45f, -1.849f, font_texture, 0.4, 0.165f);
 
 	}
 
@@ -1065,51 +1487,112 @@ public:
 	}
 
 
-	void barrier_take_hit(Barrier* this_barrier){
-		this_barrier->advance_active_animation();
+	//Blasts a crater around the texel a bullet struck, the barrier goes once nothing is left
+	void barrier_take_hit(GameObject& this_barrier, int texel_x, int texel_y){
+		if (barrier_atlas.carve(this_barrier.slot, texel_x, texel_y, 3)){
+			this_barrier.destroy();
+		}
+		static_layer.invalidate();
 	}
 
 
+	//Pixel-accurate swept test of a bullet against a barrier's mask, same result as swept_box_collision.
+	//impact_x/y get the mask texel under the bullet's leading edge at the hit.
+	float barrier_sweep(const GameObject& bullet, const GameObject& barrier, int* impact_x, int* impact_y){
+		if (swept_box_collision(bullet, barrier) < 0.0f){
+			return -1.0f;
+		}
+
+		//Texel space: x right from the barrier's left edge, y down from its top edge
+		float texels_per_x = BARRIER_MASK_WIDTH / barrier.width();
+		float texels_per_y = BARRIER_MASK_HEIGHT / barrier.height();
+		float left = barrier.top_left_x();
+		float top = barrier.top_left_y() + barrier.height();
+
+		float dx, dy;
+		entity_motion(bullet, elapsed, &dx, &dy);
+		float start_x = bullet.top_left_x() - dx;
+		float start_y = bullet.top_left_y() - dy;
+
+		float x0 = (start_x - left) * texels_per_x;
+		float x1 = (start_x + bullet.width() - left) * texels_per_x;
+		float y0 = (top - (start_y + bullet.height())) * texels_per_y;
+		float y1 = (top - start_y) * texels_per_y;
+		float time = barrier_atlas.mask(barrier.slot).sweep(x0, y0, x1, y1, dx * texels_per_x, -dy * texels_per_y);
+
+		if (time >= 0.0f){
+			*impact_x = (int)floorf((x0 + x1) / 2 + dx * texels_per_x * time);
+			*impact_y = (int)floorf((dy > 0 ? y0 : y1) - dy * texels_per_y * time);
+		}
+		return time;
+	}
+
+
+	void earliest_hit(const GameObject& bullet, GameObject& target, float* hit_time, GameObject** hit, int* impact_x, int* impact_y){
+		int texel_x = 0;
+		int texel_y = 0;
+		float time = target.type == ENTITY_BARRIER ? barrier_sweep(bullet, target, &texel_x, &texel_y) : swept_box_collision(bullet, target);
+		if (time >= 0.0f && time < *hit_time){
+			*hit_time = time;
+			*hit = &target;
+			*impact_x = texel_x;
+			*impact_y = texel_y;
+		}
+	}
+
 	void handle_collisions(){
+		PROFILE_ZONE("GameLevel::handle_collisions");
+		ALLOC_TAG("GameLevel::handle_collisions");
 
 		for (int x = 0; x < bullets.size(); x++){
-			bool continue_to_next_loop = false;
-
-			if (bullets[x].strings["shooter_name"] == "hero"){
-				for (int y = 0; y < enemies.size(); y++){
-					if (check_box_collision(bullets[x], enemies[y])){
-						bullets[x].destroy();
-						enemies[y].destroy();
-						score += 10;
-						continue_to_next_loop = true;
-						break;
-					}
+			GameObject& bullet = bullets[x];
+			if (bullet.destroyed){
+				continue;
+			}
+
+			//The earliest target along this tick's path takes the hit, so a fast bullet
+			//or a long frame can't tunnel through a target or reach one behind it
+			float hit_time = 2.0f;
+			GameObject* hit = NULL;
+			int impact_x = 0;
+			int impact_y = 0;
+			int hit_row = -1;
+			int hit_column = -1;
+
+			if (bullet.team == TEAM_HERO){
+				float time = formation_sweep(bullet, &hit_row, &hit_column);
+				if (time >= 0.0f){
+					hit_time = time;
 				}
 			}
 			else{
-				if (check_box_collision(bullets[x], player)){
-					player_got_hit();
-					bullets[x].destroy();
-					continue_to_next_loop = true;
-					break;
-				}
+				earliest_hit(bullet, player, &hit_time, &hit, &impact_x, &impact_y);
+			}
+
+			for (int z = 0; z < barriers.size(); z++){
+				earliest_hit(bullet, barriers[z], &hit_time, &hit, &impact_x, &impact_y);
 			}
 
 
-			if (continue_to_next_loop){
+			//A barrier or the player only wins if it was hit before any enemy
+			if (hit == NULL){
+				if (hit_row >= 0){
+					bullet.destroy();
+					formation.kill(hit_row, hit_column);
+					score += current_wave().get().rows[hit_row].points;
+				}
 				continue;
 			}
 
-			for (int z = 0; z < barriers.size(); z++){
-				if (check_box_collision(bullets[x], *barriers[z])){
-					barrier_take_hit(barriers[z]);
-					bullets[x].destroy();
-					continue_to_next_loop = true;
+			bullet.destroy();
+			switch (hit->type){
+				case ENTITY_PLAYER:
+					player_got_hit();
+					break;
+				case ENTITY_BARRIER:
+					barrier_take_hit(*hit, impact_x, impact_y);
 					break;
-				}
 			}
-			
-			
 		}
 	}
 
@@ -1117,7 +1600,27 @@ public:
 
 
 	void process_input(){
-		Uint8* keysArray = const_cast <Uint8*> (SDL_GetKeyboardState(NULL));
+		ALLOC_TAG("GameLevel::process_input");
+		SDL_Event event;
+		while (SDL_PollEvent(&event)) {
+			if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
+				done = true;
+			}
+			handle_debug_keys(event);
+			frame_pacer.note_input(event);
+
+
+			if (event.type == SDL_KEYDOWN){
+				if (event.key.keysym.sym == SDLK_SPACE){
+					bullets.push_back(player.shoot(player_bullet_animation));
+					latency_harness.input_reflected(SDLK_SPACE);
+				}
+			}
+		}
+
+
+		//Read after polling, the poll pumps this frame's key changes into the state array
+		const Uint8* keysArray = replay_keys != NULL ? replay_keys : SDL_GetKeyboardState(NULL);
 
 		if (keysArray[SDL_SCANCODE_RETURN]){
 			printf("MESSAGE: <RETURN> is pressed...\n");
@@ -1138,47 +1641,68 @@ public:
 		if (keysArray[SDL_SCANCODE_A]){
 			player.move_left();
 		}
+	}
 
 
 
-		SDL_Event event;
-		while (SDL_PollEvent(&event)) {
-			if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
-				done = true;
-			}
-
+};
 
-			if (event.type == SDL_KEYDOWN){
-				if (event.key.keysym.sym == SDLK_SPACE){
-					Animation bullet_animation;
-					Sprite bullet_sprite(sprite_sheet_texture, 112.0f / sheet_width, 0.0f / sheet_height, 16.0f / sheet_width, 16.0f / sheet_height, 0.35);
 
-					bullet_animation.add_sprite(bullet_sprite);
+MainMenu* mainMenu;
+GameLevel* gameLevel;
 
 
-					bullets.push_back(player.shoot(bullet_animation));
-				}
-			}
-		}
+//Frame timing, GL work and entity counts from the rolling history in perf_history
+void draw_perf_overlay(){
+	int enemies_alive = gameLevel->formation.alive_count();
 
+	const PerfCounters& last = perf_history.last_frame;
+	const char* lines[] = {
+		frame_sprintf("frame ms avg %.2f p99 %.2f", perf_history.frame_ms.average(), perf_history.frame_ms.percentile(0.99f)),
+		frame_sprintf("input latency ms avg %.1f p99 %.1f", frame_pacer.input_latency_ms().average(), frame_pacer.input_latency_ms().percentile(0.99f)),
+		frame_sprintf("draws avg %.1f p99 %.0f culled %u", perf_history.draw_calls.average(), perf_history.draw_calls.percentile(0.99f), last.culled),
+		frame_sprintf("state changes avg %.1f p99 %.0f", perf_history.state_changes.average(), perf_history.state_changes.percentile(0.99f)),
+		frame_sprintf("uploads avg %.1f p99 %.0f", perf_history.uploads.average(), perf_history.uploads.percentile(0.99f)),
+		frame_sprintf("enemies %d bullets %d barriers %d", enemies_alive, (int)gameLevel->bullets.size(), (int)gameLevel->barriers.size()),
+		frame_sprintf("allocs/frame %u", alloc_last_frame_stats().allocs)
+	};
 
+	float y = 1.85f;
+	for (int i = 0; i < sizeof(lines) / sizeof(lines[0]); i++){
+		draw_text(lines[i], 0.6f, y, font_texture, 0.2f, 0.09f);
+		y -= 0.15f;
 	}
+}
 
 
+//Render-on-change for the text-only screens. They are redrawn after input, a mode
+//switch or request_redraw(), the game level and the debug overlays every frame.
+bool screen_dirty = true;
+GameMode last_rendered_mode = STATE_MAIN_MENU;
 
-};
-
+//Longest the loop sleeps on an idle screen before it checks again
+const Uint32 idle_wait_ms = 250;
 
-MainMenu* mainMenu;
-GameLevel* gameLevel;
+void request_redraw(){
+	screen_dirty = true;
+}
 
+bool screen_needs_redraw(){
+	return mode == STATE_GAME_LEVEL || mode != last_rendered_mode || screen_dirty || show_perf_overlay || show_alloc_overlay;
+}
 
 void render_game() {
+	PROFILE_ZONE("render_game");
+	//The only camera upload of the frame, every program reads it from the Camera block
+	camera_buffer->update(projectionMatrix, viewMatrix);
+
 	switch (mode) {
 		case STATE_MAIN_MENU:
+			glClear(GL_COLOR_BUFFER_BIT);
 			mainMenu->render();
 			break;
 		case STATE_GAME_LEVEL:
+			//Clears itself, or skips the clear when its static layer covers the screen
 			gameLevel->render();
 			break;
 		case STATE_GAME_OVER:
@@ -1190,9 +1714,20 @@ void render_game() {
 			draw_text("YOU WON", -1.0f, 0, font_texture, 0.5, 0.3);
 			break;
 	}
+
+	if (show_alloc_overlay){
+		ALLOC_TAG("alloc overlay");
+		draw_alloc_overlay();
+	}
+
+	if (show_perf_overlay){
+		ALLOC_TAG("perf overlay");
+		draw_perf_overlay();
+	}
 }
 
 void update_game() {
+	PROFILE_ZONE("update_game");
 	switch (mode) {
 		case STATE_MAIN_MENU:
 			mainMenu->update();
@@ -1204,6 +1739,7 @@ void update_game() {
 }
 
 void process_input() {
+	PROFILE_ZONE("process_input");
 	switch (mode) {
 		case STATE_MAIN_MENU:
 			mainMenu->process_input();
@@ -1217,6 +1753,8 @@ void process_input() {
 				if (event.type == SDL_QUIT || event.type == SDL_WINDOWEVENT_CLOSE) {
 					done = true;
 				}
+				handle_debug_keys(event);
+				frame_pacer.note_input(event);
 			}
 			break;
 	}
@@ -1226,68 +1764,686 @@ void process_input() {
 
 
 
+float max_matrix_difference(const Matrix& a, const Matrix& b){
+	float difference = 0;
+	for (int i = 0; i < 16; i++){
+		difference = std::max(difference, fabsf(a.ml[i] - b.ml[i]));
+	}
+	return difference;
+}
+
+//Random angle in [0, 2pi) and offset in [-range, range), two decimals like the game's values
+float random_angle(){
+	return (rand() % 628) / 100.0f;
+}
+
+float random_offset(float range){
+	return (rand() % (int)(range * 200)) / 100.0f - range;
+}
+
+//The SIMD and in-place Matrix paths must agree with the scalar reference before their
+//timings mean anything. Run by --benchmark and on its own, without a window, by --self-test.
+bool check_matrix_simd(){
+	const float tolerance = 1e-4f;
+	float multiply_error = 0;
+	float inverse_error = 0;
+	float projective_inverse_error = 0;
+	float in_place_error = 0;
+	float transform_error = 0;
+
+	srand(1);
+	for (int n = 0; n < 1000; n++){
+		Matrix a;
+		a.Scale(0.5f + rand() % 4, 0.5f + rand() % 4, 1.0f);
+		a.Roll(random_angle());
+		a.Translate(random_offset(3.5f), random_offset(2.0f), 0.0f);
+		Matrix b;
+		b.Yaw(random_angle());
+		b.Translate(1.0f, (rand() % 100) / 100.0f, 0.5f);
+
+		multiply_error = std::max(multiply_error, max_matrix_difference(a * b, a.MultiplyScalar(b)));
+		inverse_error = std::max(inverse_error, max_matrix_difference(a.Inverse(), a.InverseScalar()));
+
+		//A full 4x4 with a projective bottom row, nothing like the affine transforms above
+		Matrix perspective;
+		perspective.SetPerspectiveProjection(0.5f + (rand() % 100) / 100.0f, 1.0f + (rand() % 100) / 100.0f, 0.5f, 20.0f);
+		Matrix projective = screen_projection.MultiplyScalar(perspective.MultiplyScalar(b));
+		projective_inverse_error = std::max(projective_inverse_error, max_matrix_difference(projective.Inverse(), projective.InverseScalar()));
+		projective_inverse_error = std::max(projective_inverse_error, max_matrix_difference(projective * projective.Inverse(), Matrix()));
+
+		//In-place transforms against building the transform and left-multiplying, as they used to
+		float x = random_offset(3.0f), y = random_offset(3.0f), z = random_offset(3.0f);
+		float angle = random_angle();
+		Matrix step;
+		Matrix in_place = a;
+
+		step.SetPosition(x, y, z);
+		in_place.Translate(x, y, z);
+		in_place_error = std::max(in_place_error, max_matrix_difference(in_place, step.MultiplyScalar(a)));
+
+		step = Matrix();
+		step.SetScale(x, y, z);
+		in_place = a;
+		in_place.Scale(x, y, z);
+		in_place_error = std::max(in_place_error, max_matrix_difference(in_place, step.MultiplyScalar(a)));
+
+		step = Matrix();
+		step.SetRoll(angle);
+		in_place = a;
+		in_place.Roll(angle);
+		in_place_error = std::max(in_place_error, max_matrix_difference(in_place, step.MultiplyScalar(a)));
+
+		step = Matrix();
+		step.SetPitch(angle);
+		in_place = projective;
+		in_place.Pitch(angle);
+		in_place_error = std::max(in_place_error, max_matrix_difference(in_place, step.MultiplyScalar(projective)));
+
+		step = Matrix();
+		step.SetYaw(angle);
+		in_place = projective;
+		in_place.Yaw(angle);
+		in_place_error = std::max(in_place_error, max_matrix_difference(in_place, step.MultiplyScalar(projective)));
+
+		float in[4] = { 0.3f, -0.2f, 0.0f, 1.0f };
+		float out[4];
+		a.TransformVector(in, out);
+		for (int j = 0; j < 4; j++){
+			float expected = in[0] * a.m[0][j] + in[1] * a.m[1][j] + in[2] * a.m[2][j] + in[3] * a.m[3][j];
+			transform_error = std::max(transform_error, fabsf(out[j] - expected));
+		}
+	}
+
+	bool passed = multiply_error < tolerance && inverse_error < tolerance && projective_inverse_error < tolerance &&
+		in_place_error < tolerance && transform_error < tolerance;
+	printf("Matrix SIMD vs scalar: multiply %g inverse %g projective inverse %g in-place %g transform %g %s\n",
+		multiply_error, inverse_error, projective_inverse_error, in_place_error, transform_error, passed ? "ok" : "FAILED");
+	return passed;
+}
+
+
+//--benchmark [file.json]: time the hot paths and exit instead of playing
+bool run_benchmarks(const char* json_path){
+	if (!check_matrix_simd()){
+		return false;
+	}
+
+	BenchmarkSuite suite;
+
+	Matrix a;
+	a.Translate(1.0f, 2.0f, 0.5f);
+	a.Roll(0.3f);
+	Matrix b;
+	b.Scale(2.0f, 0.5f, 1.0f);
+	Matrix result;
+
+	suite.run("Matrix::operator*", 100000, [&](int i){
+		result = a * b;
+		benchmark_do_not_optimize(&result);
+	});
+
+	suite.run("Matrix::Translate", 100000, [&](int i){
+		result.Identity();
+		result.Translate((float)i, 1.0f, 0.0f);
+		benchmark_do_not_optimize(&result);
+	});
+
+	suite.run("Matrix::Inverse", 100000, [&](int i){
+		result = a.Inverse();
+		benchmark_do_not_optimize(&result);
+	});
+
+	Affine2D affine = Affine2D::Rotation(0.3f);
+	Affine2D affine_result;
+	suite.run("Affine2D::Translate", 100000, [&](int i){
+		affine_result.Identity();
+		affine_result.Translate((float)i, 1.0f);
+		benchmark_do_not_optimize(&affine_result);
+	});
+
+	suite.run("Affine2D::operator*", 100000, [&](int i){
+		affine_result = affine * affine_result;
+		benchmark_do_not_optimize(&affine_result);
+	});
+
+	const int quad_count = 64;
+	float quad_xs[quad_count], quad_ys[quad_count], quad_half_widths[quad_count], quad_half_heights[quad_count];
+	for (int i = 0; i < quad_count; i++){
+		quad_xs[i] = -3.0f + i * 0.1f;
+		quad_ys[i] = (i % 5) * 0.46f;
+		quad_half_widths[i] = 0.22f;
+		quad_half_heights[i] = 0.22f;
+	}
+	static float quad_positions[quad_count * 12];
+	suite.run("transform_quads (64 quads)", 10000, [&](int i){
+		transform_quads(a, quad_xs, quad_ys, quad_half_widths, quad_half_heights, quad_count, quad_positions);
+		benchmark_do_not_optimize(quad_positions);
+	});
+
+	bool hit = false;
+	suite.run("check_box_collision", 1000000, [&](int i){
+		hit = check_box_collision((i % 64) * 0.05f, 0.1f, 0.1f, 0.1f, 1.0f, 0.0f, 0.44f, 0.44f);
+		benchmark_do_not_optimize(&hit);
+	});
+
+	float hit_time = 0;
+	suite.run("swept_box_collision", 1000000, [&](int i){
+		hit_time = swept_box_collision((i % 64) * 0.05f, -1.0f, 0.1f, 0.1f, 0.0f, 2.0f, 1.0f, 0.0f, 0.44f, 0.44f);
+		benchmark_do_not_optimize(&hit_time);
+	});
+
+	const char* text = "points: 1230";
+	int text_length = strlen(text);
+	float glyph_verts[12 * 32];
+	float glyph_tex_coords[12 * 32];
+	suite.run("build_text_glyphs (12 chars)", 100000, [&](int i){
+		build_text_glyphs(text, text_length, 0.4f, 0.165f, glyph_verts, glyph_tex_coords);
+		benchmark_do_not_optimize(glyph_verts);
+	});
+
+	//Full simulation tick on a fresh level, nothing is drawn. The level sees a 60Hz clock
+	//that only moves with the ticks, so each one does the same work however fast it runs.
+	GameLevel level;
+	if (!level.ready()){
+		return false;
+	}
+	elapsed = 1.0f / 60.0f;
+	replay_clock = 0.0f;
+	suite.run("GameLevel::update", 2000, [&](int i){
+		frame_arena.reset();
+		replay_clock += elapsed;
+		level.update();
+	});
+	replay_clock = -1.0f;
+	mode = STATE_MAIN_MENU;
+
+	suite.print();
+	if (json_path != NULL && !suite.write_json(json_path)){
+		std::cout << "Unable to write benchmark results to " << json_path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+
+//Scripted input for --render-test, applied at the start of the frame it names
+struct ReplayStep {
+	int frame;
+	SDL_Keycode key;
+	bool down;
+};
+
+const ReplayStep render_test_replay[] = {
+	{ 10, SDLK_SPACE, true }, { 11, SDLK_SPACE, false },
+	{ 20, SDLK_a, true }, { 70, SDLK_a, false },
+	{ 75, SDLK_SPACE, true }, { 76, SDLK_SPACE, false },
+	{ 90, SDLK_d, true }, { 200, SDLK_d, false },
+	{ 120, SDLK_SPACE, true }, { 121, SDLK_SPACE, false },
+	{ 160, SDLK_SPACE, true }, { 161, SDLK_SPACE, false },
+	{ 210, SDLK_SPACE, true }, { 211, SDLK_SPACE, false },
+};
+
+//Frames compared against <golden dir>/frame_NNNN.png, the committed set is in resources/golden
+const int render_test_captures[] = { 1, 60, 120, 180, 240 };
+
+//Goldens are stored at 1/4 size, averaging 4x4 blocks keeps a sprite or a glyph moving by
+//a pixel visible while the photographic background stays small enough to commit
+const int render_test_scale = 4;
+
+//Per channel difference a pixel may have before it counts, and how many such pixels a
+//frame may have, so a GPU and a software rasterizer can share the same goldens
+const int render_test_tolerance = 8;
+const float render_test_max_differing = 0.001f;
+
+//--render-test <golden dir> [output dir]: plays render_test_replay on a fixed 60Hz clock,
+//rendering every frame into an offscreen target, and compares the render_test_captures
+//frames with the goldens. Mismatching frames and a diff image go to the output dir, along
+//with render_benchmark.json timing render_game into the target. --update-golden rewrites
+//the goldens instead of comparing.
+bool run_render_test(const char* golden_dir, const char* output_dir, bool update_golden){
+	RenderTarget target(window_width, window_height);
+	if (!target.valid()){
+		std::cout << "Unable to create the render test framebuffer" << std::endl;
+		return false;
+	}
+
+	Uint8 keys[SDL_NUM_SCANCODES];
+	memset(keys, 0, sizeof(keys));
+	replay_keys = keys;
+	mode = STATE_GAME_LEVEL;
+	elapsed = 1.0f / 60.0f;
+
+	make_directory(output_dir);
+	if (update_golden){
+		make_directory(golden_dir);
+	}
+	bool passed = true;
+	int step = 0;
+	int step_count = sizeof(render_test_replay) / sizeof(render_test_replay[0]);
+	int capture_count = sizeof(render_test_captures) / sizeof(render_test_captures[0]);
+	std::vector<unsigned char> captured;
+	std::vector<unsigned char> actual;
+	std::vector<unsigned char> expected;
+	std::vector<unsigned char> diff_image;
+
+	for (int frame = 1, capture = 0; capture < capture_count; frame++){
+		frame_arena.reset();
+
+		//Key presses go through the event queue like real ones, held keys through keys
+		while (step < step_count && render_test_replay[step].frame == frame){
+			const ReplayStep& replay = render_test_replay[step];
+			SDL_Event event;
+			SDL_memset(&event, 0, sizeof(event));
+			event.type = replay.down ? SDL_KEYDOWN : SDL_KEYUP;
+			event.key.state = replay.down ? SDL_PRESSED : SDL_RELEASED;
+			event.key.keysym.sym = replay.key;
+			event.key.keysym.scancode = SDL_GetScancodeFromKey(replay.key);
+			SDL_PushEvent(&event);
+			keys[event.key.keysym.scancode] = replay.down ? 1 : 0;
+			step++;
+		}
+
+		replay_clock += elapsed;
+		process_input();
+		update_game();
+		target.bind();
+		render_game();
+		target.unbind();
+
+		if (frame != render_test_captures[capture]){
+			continue;
+		}
+		capture++;
+
+		target.read(&captured);
+		int width = target.get_width() / render_test_scale;
+		int height = target.get_height() / render_test_scale;
+		downsample_image(&captured[0], target.get_width(), target.get_height(), render_test_scale, &actual);
+		const char* golden_path = frame_sprintf("%s/frame_%04d.png", golden_dir, frame);
+		if (update_golden){
+			if (!write_png(golden_path, width, height, &actual[0])){
+				std::cout << "Unable to write " << golden_path << std::endl;
+				passed = false;
+			}
+			continue;
+		}
+
+		int golden_width, golden_height;
+		if (!read_png(golden_path, &golden_width, &golden_height, &expected) || golden_width != width || golden_height != height){
+			std::cout << "frame " << frame << ": no " << width << "x" << height << " golden at " << golden_path << " (run with --update-golden)" << std::endl;
+			passed = false;
+			continue;
+		}
+
+		int pixel_count = width * height;
+		ImageDiff diff = compare_images(&expected[0], &actual[0], pixel_count, render_test_tolerance);
+		bool matches = diff.differing_pixels <= pixel_count * render_test_max_differing;
+		printf("frame %d: %s, %d pixels differ, max channel difference %d\n", frame, matches ? "ok" : "MISMATCH", diff.differing_pixels, diff.max_channel_difference);
+		if (!matches){
+			passed = false;
+			make_diff_image(&expected[0], &actual[0], pixel_count, render_test_tolerance, &diff_image);
+			write_png(frame_sprintf("%s/frame_%04d_actual.png", output_dir, frame), target.get_width(), target.get_height(), &captured[0]);
+			write_png(frame_sprintf("%s/frame_%04d_diff.png", output_dir, frame), width, height, &diff_image[0]);
+		}
+	}
+
+	//Throughput of the draw path on whatever rasterizer this is, glFinish so the GPU or
+	//software renderer's work is counted and not just command submission
+	BenchmarkSuite suite;
+	suite.repetitions = 10;
+	suite.run("render_game (offscreen)", 20, [&](int i){
+		frame_arena.reset();
+		target.bind();
+		render_game();
+		glFinish();
+		target.unbind();
+	});
+	suite.run("render_game (offscreen, static layer rebuilt)", 20, [&](int i){
+		frame_arena.reset();
+		gameLevel->static_layer.invalidate();
+		target.bind();
+		render_game();
+		glFinish();
+		target.unbind();
+	});
+	suite.print();
+	const char* json_path = frame_sprintf("%s/render_benchmark.json", output_dir);
+	if (!suite.write_json(json_path)){
+		std::cout << "Unable to write " << json_path << std::endl;
+	}
+
+	replay_keys = NULL;
+	replay_clock = -1.0f;
+	return passed;
+}
+
+
 int left_score = 0;
 int right_score = 0;
 
 int main(int argc, char *argv[]) {
-	SDL_Init(SDL_INIT_VIDEO);
-	displayWindow = SDL_CreateWindow("Space Invaders <> AFL294@NYU.EDU", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 1000, 600, SDL_WINDOW_OPENGL);
-	SDL_GLContext context = SDL_GL_CreateContext(displayWindow);
+	const char* trace_path = NULL;
+	bool benchmark_mode = false;
+	const char* benchmark_path = NULL;
+	//--benchmark [file.json] times the hot paths and exits
+	//--self-test checks the Matrix fast paths against the scalar reference and exits, needs no display
+	//--trace <file> writes a Chrome trace on exit (needs a PROFILING build)
+	//--alloc-csv <file> dumps per-frame heap numbers
+	//--vsync off|on|adaptive picks the swap interval (default adaptive)
+	//--fps <n> caps the frame rate when vsync is off, 0 for unlimited (default the display rate)
+	//--latency-test <file.json> starts the level, injects shots and writes input-to-photon latency
+	//--compile-wave <in.txt> <out.wave> converts a wave source to the binary the game loads, then exits
+	//--hot-reload watches shaders and textures and reloads them in place when they change
+	//--gl compat skips the GL 3.3 core context and uses the legacy shaders
+	//--render-test <golden dir> [output dir] replays a scripted game offscreen and compares frames, see run_render_test
+	//--update-golden makes --render-test rewrite the goldens
+	VsyncMode vsync_mode = VSYNC_ADAPTIVE;
+	int target_fps = -1;
+	const char* latency_path = NULL;
+	bool core_profile = true;
+	const char* render_test_dir = NULL;
+	const char* render_test_output = "render_test_output";
+	bool update_golden = false;
+	for (int i = 1; i < argc; i++){
+		if (strcmp(argv[i], "--self-test") == 0){
+			return check_matrix_simd() ? 0 : 1;
+		}
+		else if (strcmp(argv[i], "--benchmark") == 0){
+			benchmark_mode = true;
+			if (i + 1 < argc && argv[i + 1][0] != '-'){
+				benchmark_path = argv[i + 1];
+				i++;
+			}
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc){
+			trace_path = argv[i + 1];
+			i++;
+		}
+		else if (strcmp(argv[i], "--alloc-csv") == 0 && i + 1 < argc){
+			if (!alloc_csv_open(argv[i + 1])){
+				std::cout << "Unable to open allocation CSV " << argv[i + 1] << std::endl;
+			}
+			i++;
+		}
+		else if (strcmp(argv[i], "--vsync") == 0 && i + 1 < argc){
+			if (strcmp(argv[i + 1], "off") == 0){
+				vsync_mode = VSYNC_OFF;
+			}
+			else if (strcmp(argv[i + 1], "on") == 0){
+				vsync_mode = VSYNC_ON;
+			}
+			else if (strcmp(argv[i + 1], "adaptive") == 0){
+				vsync_mode = VSYNC_ADAPTIVE;
+			}
+			else{
+				std::cout << "Unknown --vsync mode " << argv[i + 1] << ", expected off, on or adaptive" << std::endl;
+				return 1;
+			}
+			i++;
+		}
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc){
+			target_fps = atoi(argv[i + 1]);
+			i++;
+		}
+		else if (strcmp(argv[i], "--latency-test") == 0 && i + 1 < argc){
+			latency_path = argv[i + 1];
+			i++;
+		}
+		else if (strcmp(argv[i], "--gl") == 0 && i + 1 < argc){
+			core_profile = strcmp(argv[i + 1], "compat") != 0;
+			i++;
+		}
+		else if (strcmp(argv[i], "--render-test") == 0 && i + 1 < argc){
+			render_test_dir = argv[i + 1];
+			i++;
+			if (i + 1 < argc && argv[i + 1][0] != '-'){
+				render_test_output = argv[i + 1];
+				i++;
+			}
+		}
+		else if (strcmp(argv[i], "--update-golden") == 0){
+			update_golden = true;
+		}
+		else if (strcmp(argv[i], "--hot-reload") == 0){
+			hot_reload = true;
+		}
+		else if (strcmp(argv[i], "--compile-wave") == 0 && i + 2 < argc){
+			std::vector<char> text;
+			WaveFile wave;
+			if (!read_text_file(argv[i + 1], &text)){
+				std::cout << "Unable to open " << argv[i + 1] << std::endl;
+				return 1;
+			}
+			if (!wave.load_text(&text[0], argv[i + 1]) || !wave.save(argv[i + 2])){
+				return 1;
+			}
+			return 0;
+		}
+	}
+
+	//Render tests run on CI machines with no display, SDL's offscreen driver gets a context from EGL
+	//(Mesa's llvmpipe when there is no GPU). An SDL_VIDEODRIVER already set wins.
+	if (render_test_dir != NULL){
+		SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+	}
+	if (SDL_Init(latency_path != NULL ? SDL_INIT_VIDEO | SDL_INIT_TIMER : SDL_INIT_VIDEO) != 0 && render_test_dir != NULL){
+		std::cout << "No offscreen video driver (" << SDL_GetError() << "), using the default one" << std::endl;
+		SDL_setenv("SDL_VIDEODRIVER", "", 1);
+		SDL_Init(SDL_INIT_VIDEO);
+	}
+	//Benchmarks and render tests still need a GL context, but nothing is shown
+	bool headless = benchmark_mode || render_test_dir != NULL;
+	Uint32 window_flags = headless ? SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN : SDL_WINDOW_OPENGL;
+	displayWindow = SDL_CreateWindow("Space Invaders <> AFL294@NYU.EDU", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_width, window_height, window_flags);
+	//Core contexts stay on the drivers' fast paths, older drivers fall back to a compatibility context
+	SDL_GLContext context = NULL;
+	if (core_profile){
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		context = SDL_GL_CreateContext(displayWindow);
+		if (context == NULL){
+			std::cout << "No GL 3.3 core context (" << SDL_GetError() << "), using compatibility" << std::endl;
+			SDL_GL_ResetAttributes();
+			core_profile = false;
+		}
+	}
+	if (context == NULL){
+		context = SDL_GL_CreateContext(displayWindow);
+	}
 	SDL_GL_MakeCurrent(displayWindow, context);
 	#ifdef _WINDOWS
+		//Without this GLEW skips entry points it finds through the extension string, which core contexts don't have
+		glewExperimental = GL_TRUE;
 		glewInit();
 	#endif
+	gl_core_init();
 
 
 
 	font_texture = LoadTexture("resources/font.png", &font_sheet_width, &font_sheet_height);
 
 
-	glViewport(0, 0, 1000, 600);
+	glViewport(0, 0, window_width, window_height);
 
 	tex_program = new ShaderProgram();
 
-	tex_program->Load(RESOURCE_FOLDER"vertex_textured.glsl", RESOURCE_FOLDER"fragment_textured.glsl");
+	//The *_2d vertex shaders take the model transform as one vec4 instead of a mat4,
+	//*_core.glsl are the same shaders for #version 330 core
+	if (core_profile){
+		tex_program->Load(RESOURCE_FOLDER"vertex_textured_2d_core.glsl", RESOURCE_FOLDER"fragment_textured_core.glsl");
+	}
+	else{
+		tex_program->Load(RESOURCE_FOLDER"vertex_textured_2d.glsl", RESOURCE_FOLDER"fragment_textured.glsl");
+	}
 
 
 	shape_program = new ShaderProgram();
 	
-	shape_program->Load(RESOURCE_FOLDER"vertex.glsl", RESOURCE_FOLDER"fragment.glsl");
+	if (core_profile){
+		shape_program->Load(RESOURCE_FOLDER"vertex_2d_core.glsl", RESOURCE_FOLDER"fragment_core.glsl");
+	}
+	else{
+		shape_program->Load(RESOURCE_FOLDER"vertex_2d.glsl", RESOURCE_FOLDER"fragment.glsl");
+	}
+
+	camera_buffer = new CameraBuffer();
+	tex_program->BindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+	shape_program->BindUniformBlock("Camera", CAMERA_BLOCK_BINDING);
+
+	if (hot_reload){
+		ShaderProgram* programs[] = { tex_program, shape_program };
+		for (ShaderProgram* program : programs){
+			file_watcher.watch(program->vertexShaderFile, [program]{ program->Reload(); });
+			file_watcher.watch(program->fragmentShaderFile, [program]{ program->Reload(); });
+		}
+	}
 
 
+	if (benchmark_mode){
+		bool benchmarks_passed = run_benchmarks(benchmark_path);
+		delete tex_program;
+		delete shape_program;
+		delete camera_buffer;
+		gl_core_cleanup();
+		SDL_Quit();
+		return benchmarks_passed ? 0 : 1;
+	}
+
+	//Enemy fire picks columns with rand(), render tests need the same picks every run
+	if (render_test_dir != NULL){
+		srand(1);
+		replay_clock = 0.0f;
+	}
+	else{
+		srand(time(NULL));
+	}
+
 	mainMenu = new MainMenu();
 	gameLevel = new GameLevel();
+	if (!gameLevel->ready()){
+		delete mainMenu;
+		delete gameLevel;
+		delete tex_program;
+		delete shape_program;
+		delete camera_buffer;
+		gl_core_cleanup();
+		SDL_Quit();
+		return 1;
+	}
+
+
+	frame_pacer.set_vsync(vsync_mode);
+	frame_pacer.set_target_fps(target_fps >= 0 ? target_fps : display_refresh_rate(displayWindow));
 
 	float lastFrameTicks = 0.0f;
 
 
 
 
-	float screen_left = -3.55;
-	float screen_right = 3.55;
-	float screen_top = 2.0f;
-	float screen_bottom = -2.0f;
-	projectionMatrix.SetOrthoProjection(screen_left, screen_right, screen_bottom, screen_top, -1.0f, 1.0f);
+	projectionMatrix = screen_projection;
 
 
 	mode = STATE_MAIN_MENU;
+	if (latency_path != NULL){
+		mode = STATE_GAME_LEVEL;
+		latency_harness.start(SDLK_SPACE, 200);
+	}
 
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+	if (render_test_dir != NULL){
+		bool render_test_passed = run_render_test(render_test_dir, render_test_output, update_golden);
+		std::cout << (render_test_passed ? "render test passed" : "render test FAILED") << std::endl;
+		delete mainMenu;
+		delete gameLevel;
+		delete tex_program;
+		delete shape_program;
+		delete camera_buffer;
+		gl_core_cleanup();
+		SDL_Quit();
+		return render_test_passed ? 0 : 1;
+	}
+
+	int frame_count = 0;
+	Uint64 frame_start = SDL_GetPerformanceCounter();
+
 	while (!done) {
+		//Reloads happen between frames, textures and programs keep their GL names so nothing else notices
+		if (hot_reload && file_watcher.poll() > 0){
+			gameLevel->static_layer.invalidate();
+			request_redraw();
+		}
+
+		//Nothing on screen would change, so block until an event arrives instead of redrawing the same text.
+		//A latency run keeps presenting so a probe that lands on an end screen still times out.
+		if (!screen_needs_redraw() && !latency_harness.active()){
+			PROFILE_ZONE("idle wait");
+			if (SDL_WaitEventTimeout(NULL, idle_wait_ms)){
+				request_redraw();
+			}
+
+			//The wait is neither frame time nor simulation time
+			lastFrameTicks = get_runtime();
+			frame_start = SDL_GetPerformanceCounter();
+			continue;
+		}
+
+		PROFILE_ZONE("frame");
+		frame_arena.reset();
+		alloc_tracker_begin_frame();
+		#ifdef ALLOC_TRACKING
+			GameMode mode_at_frame_start = mode;
+		#endif
+
+		//Sleep off the frame budget before sampling input rather than between render and swap,
+		//so the input a frame acts on is as fresh as possible when it is shown
+		frame_pacer.wait_for_deadline();
+
 		float ticks = get_runtime();
 		elapsed = ticks - lastFrameTicks;
 		lastFrameTicks = ticks;
 
-		glClear(GL_COLOR_BUFFER_BIT);
-
-
 		process_input();
 		update_game();
 		render_game();
+		screen_dirty = false;
+		last_rendered_mode = mode;
+
+		{
+			PROFILE_ZONE("SDL_GL_SwapWindow");
+			SDL_GL_SwapWindow(displayWindow);
+		}
+		frame_pacer.frame_presented();
+
+		if (latency_harness.active()){
+			//Probes press fire in the level, once the player dies or clears the last wave no more will land
+			if (mode != STATE_GAME_LEVEL){
+				latency_harness.stop("the game left the level");
+			}
+			latency_harness.frame_presented();
+			if (latency_harness.finished()){
+				latency_harness.print();
+				if (!latency_harness.write_json(latency_path)){
+					std::cout << "Unable to write latency results " << latency_path << std::endl;
+				}
+				done = true;
+			}
+		}
 
-		SDL_GL_SwapWindow(displayWindow);
+		//Once warmed up, a frame that stays in the same mode must not call the global new.
+		//The last frame is exempt, it may have written a report on the way out.
+		#ifdef ALLOC_TRACKING
+			if (frame_count > 60 && mode == mode_at_frame_start && !done){
+				assert(alloc_frame_stats().allocs == 0);
+			}
+		#endif
+		frame_count += 1;
+
+		Uint64 frame_end = SDL_GetPerformanceCounter();
+		perf_end_frame((float)(frame_end - frame_start) / (float)SDL_GetPerformanceFrequency());
+		frame_start = frame_end;
 	}
 
 	//Cleanup
@@ -1295,6 +2451,13 @@ int main(int argc, char *argv[]) {
 	delete gameLevel;
 	delete tex_program;
 	delete shape_program;
+	delete camera_buffer;
+	gl_core_cleanup();
+
+	alloc_csv_close();
+	if (trace_path != NULL && !profiler_write_chrome_trace(trace_path)){
+		std::cout << "Unable to write trace " << trace_path << " (is PROFILING defined?)" << std::endl;
+	}
 
 	SDL_Quit();
 	return 0;
@@ -0,0 +1,22 @@
+#extension GL_ARB_uniform_buffer_object : require
+attribute vec4 position;
+attribute vec2 texCoord;
+
+// Affine2D from ShaderProgram::SetTransform2D: xy = (a, b), zw = (c, d)
+uniform vec4 transform;
+uniform vec2 translation;
+
+// Shared by every program, updated once per frame (CameraBuffer)
+layout(std140) uniform Camera {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+};
+
+varying vec2 texCoordVar;
+
+void main()
+{
+	vec2 p = position.x * transform.xy + position.y * transform.zw + translation;
+    texCoordVar = texCoord;
+	gl_Position = projectionMatrix * viewMatrix * vec4(p, position.z, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+// Core profile variant of vertex_textured_2d.glsl, also valid as "#version 300 es"
+in vec4 position;
+in vec2 texCoord;
+
+// Affine2D from ShaderProgram::SetTransform2D: xy = (a, b), zw = (c, d)
+uniform vec4 transform;
+uniform vec2 translation;
+
+// Shared by every program, updated once per frame (CameraBuffer)
+layout(std140) uniform Camera {
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+};
+
+out vec2 texCoordVar;
+
+void main()
+{
+	vec2 p = position.x * transform.xy + position.y * transform.zw + translation;
+	texCoordVar = texCoord;
+	gl_Position = projectionMatrix * viewMatrix * vec4(p, position.z, 1.0);
+}